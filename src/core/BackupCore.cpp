@@ -1,61 +1,156 @@
 #include "BackupCore.h"
 #include <fstream>
 #include <iostream>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <sys/stat.h>
+#include "DirWalker.h"
 #include "spdlog/spdlog.h"
 
 using namespace std;
 namespace fs = std::filesystem;
 
-// 遍历目录树，筛选符合规则的文件
-void BackupCore::traverseDir(const fs::path& srcDir, vector<fs::path>& fileList, const FilterRule& rule) {
-    if (!fs::exists(srcDir) || !fs::is_directory(srcDir)) return;
+// 遍历线程与打包阶段之间的条目队列长度
+static const size_t kEntryQueueSize = 4096;
 
-    for (const auto& entry : fs::directory_iterator(srcDir)) {
-        // 应用筛选规则（路径、类型、大小、时间等）
-        if (rule.match(entry.path())) {
-            fileList.push_back(entry.path());
-        }
+// 字典训练的样本：最多kDictSampleFiles个普通文件，每个取开头kDictSampleBytes字节
+static const size_t kDictSampleFiles = 4096;
+static const size_t kDictSampleBytes = 4096;
+
+// 字典训练的样本在正式遍历中顺带读取：遍历线程对符合规则的非空普通文件读取开头部分，
+// 类型和大小直接用遍历时读取的元数据判断，不再单独遍历目录树
+class DictSampler {
+public:
+    explicit DictSampler(bool enabled) : m_full(!enabled) {}
+
+    void add(const fs::path& path, const FileMeta& meta) {
+        if (m_full || !S_ISREG(meta.mode) || meta.size == 0) return;
+        ifstream in(path, ios::binary);
+        string data(min<uint64_t>(meta.size, kDictSampleBytes), '\0');
+        in.read(&data[0], data.size());
+        data.resize(in.gcount());
+        if (data.empty()) return;
+
+        lock_guard<mutex> lock(m_mutex);
+        if (m_samples.size() < kDictSampleFiles) m_samples.push_back(std::move(data));
+        if (m_samples.size() >= kDictSampleFiles) m_full = true;
+    }
+
+    // 样本已足够（未启用时始终为true）
+    bool full() const { return m_full; }
+
+    vector<string> take() {
+        lock_guard<mutex> lock(m_mutex);
+        return std::move(m_samples);
+    }
+
+private:
+    mutex m_mutex;
+    vector<string> m_samples;
+    atomic<bool> m_full;
+};
+
+// 打包、压缩、加密、写盘各占一个线程，阶段之间通过有界队列传递可复用的缓冲块，
+// 总耗时接近最慢的阶段而不是各阶段之和
+bool BackupCore::runBackupPipeline(const BackupConfig& config, BoundedQueue<PackUnpack::PackEntry>& entries,
+                                   const string& backupFile, const string& dictionary) {
+    FileByteSink fileSink(backupFile);
+    if (!fileSink.isOpen()) {
+        spdlog::error("无法创建备份文件：{}", backupFile);
+        return false;
     }
+    ThreadedSink writeStage(fileSink);
+
+    auto encryptor = Crypto::createEncryptor(config.cryptoAlg, config.password, writeStage);
+    if (!encryptor) {
+        spdlog::error("加密失败！");
+        return false;
+    }
+    ThreadedSink encryptStage(*encryptor);
+
+    auto compressor = Compress::createCompressor(config.compressAlg, encryptStage, config.compressLevel, 0, dictionary);
+    if (!compressor) {
+        spdlog::error("压缩失败！");
+        return false;
+    }
+    ThreadedSink compressStage(*compressor);
+
+    // 读取与打包在当前线程执行
+    return PackUnpack::pack(entries, compressStage, config.packAlg);
 }
 
 // 备份核心逻辑
 bool BackupCore::backup(const BackupConfig& config) {
     try {
-        // 1. 筛选文件（自定义备份功能）
-        vector<fs::path> fileList;
-        traverseDir(config.srcPath, fileList, config.filterRule);
-        if (fileList.empty()) {
-            spdlog::warn("没有符合筛选规则的文件，备份终止！");
+        if (!fs::is_directory(config.srcPath)) {
+            spdlog::error("源路径不是目录：{}", config.srcPath);
             return false;
         }
-        for_each(fileList.begin(), fileList.end(), [](const fs::path& p) {
-           spdlog::info("Selected file: {}", p.string());
+
+        // 1. 筛选文件（自定义备份功能）：多线程遍历目录树，符合规则的条目边遍历边送入打包阶段
+        BoundedQueue<PackUnpack::PackEntry> entries(kEntryQueueSize);
+        DictSampler sampler(config.compressDict);
+        atomic<size_t> matched{0};
+        bool walkOk = true;
+        thread walkThread([&] {
+            DirWalker walker(config.filterRule);
+            walkOk = walker.walk(config.srcPath, [&](const fs::path& path, const string& relPath, const FileMeta& meta) {
+                spdlog::debug("Selected file: {}", path.string());
+                matched++;
+                sampler.add(path, meta);
+                return entries.push({path, relPath});
+            });
+            entries.close();
         });
-        // 2. 打包（tar/MyPack）
-        string packFile = config.destPath + "/backup.pack";
-        if (!PackUnpack::pack(fileList, packFile, config.packAlg)) {
-            spdlog::error("打包失败！");
-            return false;
+
+        // 压缩字典需要在压缩开始之前训练好：样本足够或遍历结束前，先把遍历送来的条目取出暂存
+        // （遍历线程不会因队列满而停下），训练完成后由转发线程把暂存的条目和其余条目依次交给打包阶段
+        string dictionary;
+        BoundedQueue<PackUnpack::PackEntry>* packEntries = &entries;
+        BoundedQueue<PackUnpack::PackEntry> forwarded(kEntryQueueSize);
+        thread forwardThread;
+        if (config.compressDict) {
+            vector<PackUnpack::PackEntry> pending;
+            PackUnpack::PackEntry entry;
+            while (!sampler.full() && entries.pop(entry)) pending.push_back(std::move(entry));
+            vector<string> samples = sampler.take();
+            dictionary = Compress::trainDictionary(samples);
+            spdlog::info("从{}个文件训练压缩字典：{}字节", samples.size(), dictionary.size());
+
+            forwardThread = thread([&, pending = std::move(pending)]() mutable {
+                bool ok = true;
+                for (auto& e : pending) {
+                    if (!(ok = forwarded.push(std::move(e)))) break;
+                }
+                PackUnpack::PackEntry e;
+                while (ok && entries.pop(e)) ok = forwarded.push(std::move(e));
+                forwarded.close();
+            });
+            packEntries = &forwarded;
         }
 
-        // 3. 压缩（LZ77/Haff）
-        string compressFile = packFile + "." + config.compressAlg;
-        if (!Compress::compress(packFile, compressFile, config.compressAlg)) {
-            spdlog::error("压缩失败！");
+        // 2-4. 打包 -> 压缩 -> 加密 流水线，只有最终的加密文件写入磁盘
+        string backupFile = config.destPath + "/backup.pack." + config.compressAlg + "." + config.cryptoAlg;
+        bool ok = runBackupPipeline(config, *packEntries, backupFile, dictionary);
+        // 流水线提前失败时让转发线程和遍历线程尽快退出
+        forwarded.close();
+        entries.close();
+        if (forwardThread.joinable()) forwardThread.join();
+        walkThread.join();
+
+        if (!ok || !walkOk) {
+            spdlog::error("备份流水线执行失败！");
+            fs::remove(backupFile);
             return false;
-        } 
-        
-        // 4. 加密（AES/DES）
-        string encryptFile = compressFile + "." + config.cryptoAlg;
-        if (!Crypto::encrypt(compressFile, encryptFile, config.cryptoAlg, config.password)) {
-            spdlog::error("加密失败！");
+        }
+        if (matched == 0) {
+            spdlog::warn("没有符合筛选规则的文件，备份终止！");
+            fs::remove(backupFile);
             return false;
         }
-
-        // 删除中间文件（打包文件、压缩文件）
-        // fs::remove(packFile);
-        // fs::remove(compressFile);
-
+        spdlog::info("共备份{}个条目", matched.load());
+        spdlog::info("备份文件：{}", backupFile);
         return true;
     } catch (const fs::filesystem_error& e) {
         spdlog::error("备份异常：{}", e.what());
@@ -67,36 +162,41 @@ bool BackupCore::backup(const BackupConfig& config) {
 bool BackupCore::restore(const string& backupFile, const string& restorePath, 
                          const string& cryptoAlg, const string& password) {
     try {
-        // 1. 解密
-        string decryptFile = backupFile + ".decrypt";
-        if (!Crypto::decrypt(backupFile, decryptFile, cryptoAlg, password)) {
-            spdlog::error("解密失败（密码错误或算法不匹配）！");
-            return false;
-        }
-
-        // 2. 解压
-        string decompressFile = decryptFile + ".decompress";
-
+        // 从文件名中识别压缩算法：backup.pack.<压缩算法>.<加密算法>
         size_t lastDot = backupFile.rfind('.');
         // 找到倒数第二个点号的位置
         size_t secondLastDot = backupFile.rfind('.', lastDot - 1);
         string compressAlg = backupFile.substr(secondLastDot + 1, lastDot - secondLastDot - 1);
-
         spdlog::info("Detected compress algorithm: {}", compressAlg);
-        if (!Compress::decompress(decryptFile, decompressFile, compressAlg)) {
+
+        // 1-3. 解密 -> 解压 -> 解包 流水线，只写出最终还原的文件，各阶段在独立线程中运行
+        string packAlg = "tar"; // 默认使用tar打包算法
+        auto unpacker = PackUnpack::createUnpacker(restorePath, packAlg);
+        if (!unpacker) {
+            spdlog::error("解包失败！");
+            return false;
+        }
+        ThreadedSink unpackStage(*unpacker);
+
+        auto decompressor = Compress::createDecompressor(compressAlg, unpackStage);
+        if (!decompressor) {
             spdlog::error("解压失败！");
             return false;
         }
-        // 3. 解包
-        string packAlg = "tar"; // 默认使用tar打包算法
-        if (!PackUnpack::unpack(decompressFile, restorePath, packAlg)) {
-            spdlog::error("解包失败！");
+        ThreadedSink decompressStage(*decompressor);
+
+        auto decryptor = Crypto::createDecryptor(cryptoAlg, password, decompressStage);
+        if (!decryptor) {
+            spdlog::error("解密失败（算法不匹配）！");
+            return false;
+        }
+        ThreadedSink decryptStage(*decryptor);
+
+        if (!pumpFile(backupFile, decryptStage)) {
+            spdlog::error("还原失败（密码错误、算法不匹配或文件损坏）！");
             return false;
         }
 
-        // 删除中间文件
-        // fs::remove(decryptFile);
-        // fs::remove(decompressFile);
         spdlog::info("还原路径：{}", restorePath);
         return true;
     } catch (const fs::filesystem_error& e) {
@@ -16,7 +16,9 @@ public:
         std::string destPath;      // 目标路径
         FilterRule filterRule;     // 筛选规则
         std::string packAlg;       // 打包算法（tar/MyPack）
-        std::string compressAlg;   // 压缩算法（LZ77/Haff）
+        std::string compressAlg;   // 压缩算法（LZ77/Haff/LZH/ANS/LZA）
+        int compressLevel = Compress::kDefaultLevel;  // 压缩级别（1最快 - 9压缩率最高）
+        bool compressDict = false; // 从待备份文件中抽样训练字典，预置到LZ77/LZH/LZA窗口（小文件多时提高压缩率）
         std::string cryptoAlg;     // 加密算法（AES/DES）
         std::string password;      // 加密密码
     };
@@ -29,6 +31,7 @@ public:
                  const std::string& cryptoAlg, const std::string& password);
 
 private:
-    // 递归遍历目录树，收集待备份文件
-    void traverseDir(const fs::path& srcDir, std::vector<fs::path>& fileList, const FilterRule& rule);
+    // 多线程流水线：打包 -> 压缩 -> 加密 -> 写入backupFile，待打包条目从entries中取出
+    bool runBackupPipeline(const BackupConfig& config, BoundedQueue<PackUnpack::PackEntry>& entries,
+                           const std::string& backupFile, const std::string& dictionary);
 };
\ No newline at end of file
@@ -2,348 +2,2208 @@
 #include <fstream>
 #include <vector>
 #include <queue>
-#include <unordered_map>
-#include <functional>
 #include <iostream>
 #include <map>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+#include <deque>
+#include <future>
+#include <thread>
+#include <cmath>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+#include "spdlog/spdlog.h"
 
 using namespace std;
 
+// ---------------- 分块容器格式 ----------------
+// 文件头：magic "FBKZ" | 版本(1字节) | 算法(1字节)
+// 数据块：方法(1字节) | 标志(1字节) | 原始长度(4字节) | 压缩长度(4字节) | 压缩数据
+// 以方法为kBlockEnd的空块结束；不以magic开头的文件按旧的整文件格式解码
+namespace {
 
+const char kMagic[4] = {'F', 'B', 'K', 'Z'};
+const uint8_t kFormatVersion = 1;
+const size_t kHeaderSize = 6;
+const size_t kBlockHeaderSize = 10;
+const uint32_t kMaxBlockBytes = 64u << 20;   // 单块长度上限，用于识别损坏数据
+const size_t kLZ77History = 1 << 16;         // 旧token流解码时保留的历史窗口（偏移量为2字节）
+const size_t kLZWindow = 1 << 20;            // 序列格式的滑动窗口，可跨越数据块
+const size_t kHaffBlockSize = 128 << 10;     // 哈夫曼/rANS数据块大小，每块单独统计频率
+
+// 数据块标志位
+const uint8_t kFlagHistory = 0x01;           // 匹配可引用本块之前kLZWindow字节的原始数据
+const uint8_t kFlagDict = 0x02;              // 本块之前的历史为预置字典 + 最近的原始数据
+
+enum BlockMethod : uint8_t {
+    kBlockEnd = 0,      // 结束标记
+    kBlockStored = 1,   // 原样存储
+    kBlockLZ77 = 2,     // LZ77 token流（旧格式，每个token 5字节，只用于解码）
+    kBlockHaff = 3,     // 哈夫曼编码（完整频率表，旧格式，只用于解码）
+    kBlockLZSeq = 4,    // LZ77序列格式（变长字段 + 字面量串）
+    kBlockHaffCanon = 5, // 范式哈夫曼编码（只存码长）
+    kBlockLZH = 6,      // LZ77序列再做哈夫曼编码
+    kBlockDict = 7,     // 预置字典：LZ77序列格式（压缩无效时原样存储），不输出，固定在每块历史窗口的最前面
+    kBlockANS = 8,      // rANS编码（4个状态交错）
+    kBlockLZA = 9,      // LZ77序列再做rANS编码
+};
+
+// 预置字典最多占历史窗口的一半，其余留给最近的数据（窗口大小随压缩级别变化）
+size_t maxDictSize(size_t windowSize) {
+    return windowSize / 2;
+}
+
+void putU32(string& out, uint32_t v) {
+    for (int i = 0; i < 4; i++) out.push_back(char((v >> (8 * i)) & 0xFF));
+}
+
+uint32_t getU32(const char* p) {
+    uint32_t v = 0;
+    for (int i = 0; i < 4; i++) v |= uint32_t(uint8_t(p[i])) << (8 * i);
+    return v;
+}
+
+// 变长整数（LEB128）：每字节低7位为数据，最高位表示后面还有字节
+void putVarint(string& out, uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back(char((v & 0x7F) | 0x80));
+        v >>= 7;
+    }
+    out.push_back(char(v));
+}
+
+bool getVarint(const char* p, size_t len, size_t& pos, uint64_t& v) {
+    v = 0;
+    for (int shift = 0; shift < 64 && pos < len; shift += 7) {
+        uint8_t b = uint8_t(p[pos++]);
+        v |= uint64_t(b & 0x7F) << shift;
+        if (!(b & 0x80)) return true;
+    }
+    return false;
+}
+
+// 复制LZ77匹配：把dst之前offset字节处的length字节复制到dst，允许重叠（offset < length）。
+// 距离小于16时先按距离倍增展开重复模式，之后按16/8字节一组复制，不会写出dst+length之外
+inline void copyMatch(char* dst, size_t offset, size_t length) {
+    if (offset == 1) {
+        memset(dst, dst[-1], length);
+        return;
+    }
+    size_t dist = offset;
+    while (dist < 16 && length >= dist) {
+        memcpy(dst, dst - dist, dist);   // 源和目标恰好相邻，不重叠
+        dst += dist;
+        length -= dist;
+        dist *= 2;                       // 仍是offset的整数倍，模式不变
+    }
+    const char* src = dst - dist;
+    for (; length >= 16; length -= 16, src += 16, dst += 16) memcpy(dst, src, 16);
+    for (; length >= 8; length -= 8, src += 8, dst += 8) memcpy(dst, src, 8);
+    while (length-- > 0) *dst++ = *src++;
+}
+
+// 匹配长度：a、b两处从头开始相同的字节数，不超过maxLen。
+// 每次比较一组字节，用异或结果或比较掩码的末尾0个数（ctz）定位第一个不同的字节
+size_t matchLengthScalar(const char* a, const char* b, size_t maxLen) {
+    size_t len = 0;
+    for (; len + 8 <= maxLen; len += 8) {
+        uint64_t x, y;
+        memcpy(&x, a + len, 8);
+        memcpy(&y, b + len, 8);
+        if (x != y) {
+            if (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__) return len + (__builtin_ctzll(x ^ y) >> 3);
+            break;
+        }
+    }
+    while (len < maxLen && a[len] == b[len]) len++;
+    return len;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("sse2")))
+size_t matchLengthSse2(const char* a, const char* b, size_t maxLen) {
+    size_t len = 0;
+    for (; len + 16 <= maxLen; len += 16) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(a + len));
+        __m128i y = _mm_loadu_si128((const __m128i*)(b + len));
+        unsigned mask = unsigned(_mm_movemask_epi8(_mm_cmpeq_epi8(x, y))) ^ 0xFFFFu;
+        if (mask) return len + __builtin_ctz(mask);
+    }
+    return len + matchLengthScalar(a + len, b + len, maxLen - len);
+}
+
+__attribute__((target("avx2")))
+size_t matchLengthAvx2(const char* a, const char* b, size_t maxLen) {
+    size_t len = 0;
+    for (; len + 32 <= maxLen; len += 32) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(a + len));
+        __m256i y = _mm256_loadu_si256((const __m256i*)(b + len));
+        unsigned mask = ~unsigned(_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, y)));
+        if (mask) return len + __builtin_ctz(mask);
+    }
+    return len + matchLengthSse2(a + len, b + len, maxLen - len);
+}
+#endif
+
+// 启动时按CPU支持的指令集选择一次
+using MatchLengthFn = size_t (*)(const char*, const char*, size_t);
+
+MatchLengthFn selectMatchLength() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return matchLengthAvx2;
+    if (__builtin_cpu_supports("sse2")) return matchLengthSse2;
+#endif
+    return matchLengthScalar;
+}
+
+const MatchLengthFn matchLength = selectMatchLength();
+
+// 不可压缩数据检测：在块内均匀抽取若干片段统计字节分布，零阶熵接近8位/字节时
+// （JPEG、MP4、zip等已压缩的数据）哈夫曼编码不会有收益，直接原样存储。
+// 零阶熵看不出长距离重复，LZ77不用它判断，而是在连续找不到匹配时加大查找步长
+const size_t kEntropySlices = 32;
+const size_t kEntropySliceSize = 512;
+const double kIncompressibleBits = 7.9;
+
+bool looksIncompressible(const char* data, size_t size) {
+    uint32_t counts[256] = {};
+    size_t sampled = 0;
+    if (size <= kEntropySlices * kEntropySliceSize) {
+        for (size_t i = 0; i < size; i++) counts[(unsigned char)data[i]]++;
+        sampled = size;
+    } else {
+        size_t stride = size / kEntropySlices;
+        for (size_t s = 0; s < kEntropySlices; s++) {
+            const char* p = data + s * stride;
+            for (size_t i = 0; i < kEntropySliceSize; i++) counts[(unsigned char)p[i]]++;
+        }
+        sampled = kEntropySlices * kEntropySliceSize;
+    }
+    if (sampled < kEntropySliceSize) return false;   // 样本太少，估计不可靠
+
+    double bits = 0;
+    for (uint32_t c : counts) {
+        if (c == 0) continue;
+        double p = double(c) / sampled;
+        bits -= p * log2(p);
+    }
+    return bits >= kIncompressibleBits;
+}
+
+// 只做熵编码（按kHaffBlockSize分块）时的大小下限：各块零阶熵之和加块头。
+// 哈夫曼和rANS的结果都不会低于零阶熵，原样存储的块更大
+size_t literalBound(const char* data, size_t size) {
+    double bits = 0;
+    size_t blocks = 0;
+    for (size_t pos = 0; pos < size; pos += kHaffBlockSize) {
+        size_t n = min(kHaffBlockSize, size - pos);
+        uint32_t counts[256] = {};
+        for (size_t i = 0; i < n; i++) counts[(unsigned char)data[pos + i]]++;
+        for (uint32_t c : counts) {
+            if (c > 0) bits -= c * log2(double(c) / n);
+        }
+        blocks++;
+    }
+    return size_t(bits / 8) + blocks * kBlockHeaderSize;
+}
+
+} // namespace
+
+
+// LZ77序列格式（kBlockLZSeq）：数据块由若干序列组成，每个序列为
+//   token(1字节) | [字面量长度扩展] | 字面量 | 偏移量 | [匹配长度扩展]
+// token高4位是字面量长度，低4位是(匹配长度-MIN_MATCH)，取值15时后面跟一个varint扩展；
+// 偏移量为varint（LEB128）。数据块的最后一个序列只有字面量，原始长度由块头给出。
+// 带kFlagHistory标志的块，偏移量可以越过块首，指向之前的数据（窗口跨块滑动）
 class LZ77Compress{
+public:
+    // 序列的三部分：token、字面量、变长字段（偏移量和长度扩展）。
+    // 序列格式中三者指向同一个串，按序列依次交错；LZH分成三个串分别做熵编码
+    struct SeqOutput {
+        string& tokens;
+        string& literals;
+        string& extras;
+    };
+    struct SeqInput {
+        const char* data;
+        size_t len;
+        size_t& pos;
+    };
+
+    // 匹配查找的编译期配置：窗口大小、哈希位数和是否惰性匹配都是模板参数，
+    // 窗口取模、哈希移位等按常数编译。每个压缩级别选用其中一种
+    enum Profile { kProfileFast, kProfileGreedy, kProfileGreedyFull, kProfileLazy };
+
+    // 压缩级别对应的参数：级别越高，比较的候选越多、窗口越大，压缩越慢
+    struct Level {
+        Profile profile;
+        int chainDepth;     // 每个位置最多比较的候选数
+        int niceLength;     // 找到这么长的匹配就停止查找，也不再尝试惰性匹配
+    };
+
+    static const Level& level(int level) {
+        static const Level levels[] = {
+            {kProfileFast,       4,    16},       // 1
+            {kProfileGreedy,     8,    32},       // 2
+            {kProfileGreedyFull, 16,   32},       // 3
+            {kProfileLazy,       16,   32},       // 4
+            {kProfileLazy,       32,   64},       // 5
+            {kProfileLazy,       64,   128},      // 6
+            {kProfileLazy,       128,  256},      // 7
+            {kProfileLazy,       512,  1024},     // 8
+            {kProfileLazy,       4096, 1 << 30},  // 9
+        };
+        return levels[clamp(level, ::Compress::kMinLevel, ::Compress::kMaxLevel) - 1];
+    }
+
+    // 匹配可回溯的距离，也是压缩时需要保留给下一块的历史长度
+    static size_t windowSize(int levelValue) {
+        switch (level(levelValue).profile) {
+        case kProfileFast:   return Engine<16, 15, false>::WINDOW_SIZE;
+        case kProfileGreedy: return Engine<18, 16, false>::WINDOW_SIZE;
+        default:             return Engine<20, 16, false>::WINDOW_SIZE;
+        }
+    }
+
 private:
-    static const int WINDOW_SIZE = 4096;      // 滑动窗口大小
-    static const int LOOKAHEAD_SIZE = 18;     // 前向缓冲区大小
-    // LZ77编码结构体：(偏移量, 匹配长度, 下一个字符)
-    struct LZ77Token {
-        int offset;      // 偏移量
-        int length;      // 匹配长度
-        char nextChar;   // 下一个字符
-        
-        LZ77Token(int o = 0, int l = 0, char c = '\0') 
-            : offset(o), length(l), nextChar(c) {}
+    static const int MIN_MATCH = 4;           // 最短匹配，更短的匹配不如直接存字面量
+    static const uint32_t RUN_MASK = 15;      // token中长度字段的最大值，表示有扩展
+    static constexpr int SKIP_TRIGGER = 6;        // 连续2^6个位置没有匹配后，每次多跳过一个位置
+    static constexpr int MAX_SKIP = 32;           // 不可压缩数据上的最大查找步长
+
+    // 写出一个序列，matchLength为0表示数据块末尾只有字面量的序列
+    static void emitSequence(SeqOutput& out, const char* literals, size_t literalLength,
+                             uint32_t offset, size_t matchLength) {
+        size_t extra = matchLength ? matchLength - MIN_MATCH : 0;
+        out.tokens.push_back(char((min<size_t>(literalLength, RUN_MASK) << 4) | min<size_t>(extra, RUN_MASK)));
+        if (literalLength >= RUN_MASK) putVarint(out.extras, literalLength - RUN_MASK);
+        out.literals.append(literals, literalLength);
+        if (matchLength == 0) return;
+        putVarint(out.extras, offset);
+        if (extra >= RUN_MASK) putVarint(out.extras, extra - RUN_MASK);
+    }
+
+    // 哈希链匹配查找。哈希链按窗口大小循环使用（位置对WINDOW_SIZE取模），
+    // 窗口之外的位置不会再被查到，所以覆盖旧的链节点不影响结果
+    template <int WINDOW_LOG, int HASH_BITS, bool LAZY>
+    class Engine {
+    public:
+        static const int WINDOW_SIZE = 1 << WINDOW_LOG;
+        static_assert(WINDOW_SIZE <= int(kLZWindow), "窗口不能超过解码端保留的历史");
+
+        Engine(const Level& level)
+            : m_chainDepth(level.chainDepth), m_niceLength(level.niceLength),
+              m_head(size_t(1) << HASH_BITS, -1), m_prev(WINDOW_SIZE, -1) {}
+
+        void compress(const char* buf, size_t historyLen, size_t size, SeqOutput& out) {
+            int n = (int)(historyLen + size);
+            int pos = (int)historyLen;
+            int literalStart = pos;
+
+            m_nextInsert = max(0, pos - WINDOW_SIZE);
+            insertUntil(buf, n, pos);
+
+            // 连续找不到匹配（已压缩的数据）时逐渐加大步长，跳过的位置只加入索引不查找，
+            // 之后的重复数据仍然能匹配到
+            int misses = 0;
+            while (pos < n) {
+                int offset = 0;
+                int length = findLongestMatch(buf, n, pos, offset);
+                if (length == 0) {
+                    pos = min(pos + min(1 + (misses++ >> SKIP_TRIGGER), MAX_SKIP), n);
+                    insertUntil(buf, n, pos);
+                    continue;
+                }
+                misses = 0;
+                // 惰性匹配：下一个位置有更长的匹配时，当前字节并入字面量
+                while (LAZY && length < m_niceLength && pos + 1 < n) {
+                    insertUntil(buf, n, pos + 1);
+                    int nextOffset = 0;
+                    int nextLength = findLongestMatch(buf, n, pos + 1, nextOffset);
+                    if (nextLength <= length) break;
+                    pos++;
+                    length = nextLength;
+                    offset = nextOffset;
+                }
+                emitSequence(out, buf + literalStart, pos - literalStart, offset, length);
+                // 匹配覆盖的位置全部加入索引
+                pos += length;
+                insertUntil(buf, n, pos);
+                literalStart = pos;
+            }
+            if (literalStart < n) {
+                emitSequence(out, buf + literalStart, n - literalStart, 0, 0);
+            }
+        }
+
+    private:
+        static uint32_t hash4(const char* p) {
+            uint32_t v;
+            memcpy(&v, p, sizeof(v));
+            return (v * 2654435761u) >> (32 - HASH_BITS);
+        }
+
+        // 把end之前的位置加入哈希链，某个位置必须在该处的查找完成之后才加入
+        void insertUntil(const char* data, int size, int end) {
+            for (; m_nextInsert < end; m_nextInsert++) {
+                if (m_nextInsert + MIN_MATCH > size) continue;
+                uint32_t h = hash4(data + m_nextInsert);
+                m_prev[m_nextInsert & (WINDOW_SIZE - 1)] = m_head[h];
+                m_head[h] = m_nextInsert;
+            }
+        }
+
+        // 沿哈希链比较至多m_chainDepth个候选，返回最长匹配长度（不足MIN_MATCH时为0）。
+        // 查找pos时只有pos之前的位置在链中，窗口内候选的链节点还没有被覆盖
+        int findLongestMatch(const char* data, int size, int pos, int& matchOffset) {
+            int windowStart = max(0, pos - WINDOW_SIZE);
+            int maxLen = size - pos;
+            int bestLength = 0;
+            if (maxLen < MIN_MATCH) return 0;
+
+            int cand = m_head[hash4(data + pos)];
+            for (int depth = m_chainDepth; cand >= windowStart && depth > 0; depth--) {
+                // 先比较当前最长匹配之后的那个字节，不可能更长的候选直接跳过
+                if (data[cand + bestLength] == data[pos + bestLength]) {
+                    int length = (int)matchLength(data + cand, data + pos, maxLen);
+                    if (length > bestLength) {
+                        bestLength = length;
+                        matchOffset = pos - cand;
+                        if (length == maxLen || length >= m_niceLength) break;
+                    }
+                }
+                cand = m_prev[cand & (WINDOW_SIZE - 1)];
+            }
+            return bestLength >= MIN_MATCH ? bestLength : 0;
+        }
+
+        int m_chainDepth;
+        int m_niceLength;
+        vector<int32_t> m_head;       // 4字节哈希 -> 最近出现的位置
+        vector<int32_t> m_prev;       // 位置 -> 同一哈希的上一个位置（哈希链），按窗口循环
+        int m_nextInsert = 0;         // 尚未加入哈希链的第一个位置
     };
-    
-    // 在滑动窗口中查找最长匹配
-    LZ77Token findLongestMatch(const string& data, int pos) {
-        int windowStart = max(0, pos - WINDOW_SIZE);
-        int matchOffset = 0;
-        int matchLength = 0;
-        
-        // 在滑动窗口中搜索最长匹配
-        for (int i = windowStart; i < pos; i++) {
-            int length = 0;
-            // 计算从位置i开始的匹配长度
-            while (length < LOOKAHEAD_SIZE && 
-                   pos + length < data.length() && 
-                   data[i + length] == data[pos + length]) {
-                length++;
-            }
-            
-            // 更新最长匹配
-            if (length > matchLength) {
-                matchLength = length;
-                matchOffset = pos - i;
-            }
-        }
-        
-        // 获取下一个字符
-        char nextChar = (pos + matchLength < data.length()) 
-                        ? data[pos + matchLength] : '\0';
-        
-        return LZ77Token(matchOffset, matchLength, nextChar);
+
+    Level m_level;
+
+public:
+    explicit LZ77Compress(int levelValue = ::Compress::kDefaultLevel) : m_level(level(levelValue)) {}
+
+    // 压缩一块数据，序列追加到out。buf由historyLen字节的历史数据和size字节的
+    // 本块数据连续组成，匹配可以引用历史数据
+    void Compress(const char* buf, size_t historyLen, size_t size, string& out) {
+        SeqOutput seq{out, out, out};
+        Compress(buf, historyLen, size, seq);
+    }
+
+    void Compress(const char* buf, size_t historyLen, size_t size, SeqOutput& out) {
+        switch (m_level.profile) {
+        case kProfileFast:
+            Engine<16, 15, false>(m_level).compress(buf, historyLen, size, out);
+            break;
+        case kProfileGreedy:
+            Engine<18, 16, false>(m_level).compress(buf, historyLen, size, out);
+            break;
+        case kProfileGreedyFull:
+            Engine<20, 16, false>(m_level).compress(buf, historyLen, size, out);
+            break;
+        case kProfileLazy:
+            Engine<20, 16, true>(m_level).compress(buf, historyLen, size, out);
+            break;
+        }
+    }
+
+    // 解码一块序列数据，rawSize为块头中的原始长度。window中已有的数据是历史窗口，
+    // 解码结果追加在其后；historyLen为本块允许引用的历史长度（不带kFlagHistory时为0）
+    static bool Decompress(const char* in, size_t inLen, string& window, size_t historyLen, size_t rawSize) {
+        size_t ip = 0;
+        SeqInput seq{in, inLen, ip};
+        return Decompress(seq, seq, seq, window, historyLen, rawSize);
     }
 
+    // 从三个输入分别读取token、字面量和变长字段，三者可以是同一个输入
+    static bool Decompress(const SeqInput& tokens, const SeqInput& literals, const SeqInput& extras,
+                           string& window, size_t historyLen, size_t rawSize) {
+        size_t base = window.size();
+        if (historyLen > base) historyLen = base;
+        window.resize(base + rawSize);
+        char* dst = &window[0];
+        size_t lowest = base - historyLen;   // 可引用的最早位置
+        size_t end = base + rawSize;
+        size_t op = base;
+
+        while (op < end) {
+            if (tokens.pos >= tokens.len) break;
+            uint8_t token = uint8_t(tokens.data[tokens.pos++]);
+
+            uint64_t literalLength = token >> 4;
+            if (literalLength == RUN_MASK) {
+                uint64_t ext;
+                if (!getVarint(extras.data, extras.len, extras.pos, ext)) break;
+                literalLength += ext;
+            }
+            if (literalLength > literals.len - literals.pos || literalLength > end - op) break;
+            memcpy(dst + op, literals.data + literals.pos, literalLength);
+            literals.pos += literalLength;
+            op += literalLength;
+            if (op == end) break;   // 最后一个序列
+
+            uint64_t offset;
+            if (!getVarint(extras.data, extras.len, extras.pos, offset)) break;
+            uint64_t matchLength = (token & RUN_MASK) + MIN_MATCH;
+            if ((token & RUN_MASK) == RUN_MASK) {
+                uint64_t ext;
+                if (!getVarint(extras.data, extras.len, extras.pos, ext)) break;
+                matchLength += ext;
+            }
+            if (offset == 0 || offset > op - lowest || matchLength > end - op) break;
+
+            copyMatch(dst + op, offset, matchLength);
+            op += matchLength;
+        }
+
+        if (op != end || tokens.pos != tokens.len || literals.pos != literals.len || extras.pos != extras.len) {
+            spdlog::error("LZ77数据损坏");
+            return false;
+        }
+        return true;
+    }
+};
+
+// LZ77 token流增量解码器（旧格式文件与分块数据共用）
+// 最后一个token的nextChar可能是'\0'占位符：已知原始长度时按长度判断，
+// 旧格式文件不知道长度，只能把末尾token的'\0'视为占位符
+class LZ77Decoder {
 public:
-    // 压缩函数
-    bool Compress(const string& srcFile, const string& destFile) {
-        ifstream in(srcFile, ios::binary);
-        ofstream out(destFile, ios::binary);
-        if (!in.is_open() || !out.is_open()) return false;
-
-        string input((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
-        int pos = 0;
-        
-        while (pos < input.length()) {
-            LZ77Token token = findLongestMatch(input, pos);
-            // 写入压缩数据：offset(2字节), length(1字节), nextChar(1字节)
-            out.write((char*)&token.offset, 2);
-            out.write((char*)&token.length, 2);
-            out.write(&token.nextChar, 1);
-            // 移动位置：匹配长度 + 1（下一个字符）
-            pos += token.length + 1;
-        }
-        in.close();
-        out.close();
+    LZ77Decoder(ByteSink& out, int64_t rawSize = -1) : m_out(out), m_rawSize(rawSize) {}
+
+    bool feed(const char* data, size_t len) {
+        while (len > 0) {
+            size_t n = min(len, kTokenSize - m_tokenFill);
+            memcpy(m_token + m_tokenFill, data, n);
+            m_tokenFill += n;
+            data += n;
+            len -= n;
+            if (m_tokenFill < kTokenSize) break;
+            m_tokenFill = 0;
+
+            // 暂存一个token，直到确认它不是最后一个
+            if (m_hasPending && !apply(m_pending, false)) return false;
+            memcpy(m_pending, m_token, kTokenSize);
+            m_hasPending = true;
+        }
+        // 只保留匹配所需的历史窗口，其余写入下游
+        if (m_buf.size() > kStreamChunkSize + kLZ77History) {
+            return flush(kLZ77History);
+        }
         return true;
     }
-    
-    // 解压函数
-    bool Decompress(const string& compressFile, const string& destFile) {
-        ifstream in(compressFile, ios::binary);
-        ofstream out(destFile, ios::binary);
-        if (!in.is_open() || !out.is_open()) return false;
-        string output;
-        while(in.peek() != EOF) {
-            LZ77Token token;
-            // 读取压缩数据：offset(2字节), length(1字节), nextChar(1字节)
-            in.read((char*)&token.offset, 2);
-            in.read((char*)&token.length, 2);
-            in.read(&token.nextChar, 1);
-
-            // 从之前的位置复制匹配的字符串
-            if (token.length > 0 && token.offset > 0) {
-                int startPos = output.length() - token.offset;
-                for (int i = 0; i < token.length; i++) {
-                    output += output[startPos + i];
-                }
-            }
-            // 添加下一个字符
-            if (token.nextChar != '\0') {
-                output += token.nextChar;
+
+    // 输入结束：解码暂存的token并写出全部数据（不结束下游）
+    bool finish() {
+        if (m_tokenFill != 0) {
+            spdlog::error("LZ77数据不完整");
+            return false;
+        }
+        if (m_hasPending && !apply(m_pending, true)) return false;
+        m_hasPending = false;
+        return flush(0);
+    }
+
+    uint64_t produced() const { return m_produced; }
+
+private:
+    static const size_t kTokenSize = 5;
+
+    bool apply(const char* t, bool last) {
+        int offset = uint8_t(t[0]) | (uint8_t(t[1]) << 8);
+        int length = uint8_t(t[2]) | (uint8_t(t[3]) << 8);
+        char nextChar = t[4];
+
+        // 从之前的位置复制匹配的字符串
+        if (length > 0 && offset > 0) {
+            if ((size_t)offset > m_buf.size()) {
+                spdlog::error("LZ77数据损坏：偏移量越界");
+                return false;
             }
+            size_t start = m_buf.size();
+            m_buf.resize(start + length);
+            copyMatch(&m_buf[start], offset, length);
+            m_produced += length;
+        }
+        // 添加下一个字符
+        bool emit = m_rawSize >= 0 ? m_produced < (uint64_t)m_rawSize
+                                   : !(last && nextChar == '\0');
+        if (emit) {
+            m_buf += nextChar;
+            m_produced++;
         }
-        out.write(output.c_str(), output.size());
-        in.close();
-        out.close();
         return true;
     }
-    
+
+    bool flush(size_t keep) {
+        if (m_buf.size() <= keep) return true;
+        size_t n = m_buf.size() - keep;
+        if (!m_out.write(m_buf.data(), n)) return false;
+        m_buf.erase(0, n);
+        return true;
+    }
+
+    ByteSink& m_out;
+    int64_t m_rawSize;
+    string m_buf;                 // 历史窗口 + 待写出数据
+    uint64_t m_produced = 0;
+    char m_token[kTokenSize];
+    size_t m_tokenFill = 0;
+    char m_pending[kTokenSize];
+    bool m_hasPending = false;
 };
 
 
+// 范式哈夫曼格式（kBlockHaffCanon）：码长表(128字节，每个字节值4位，0表示未出现) | 编码数据
+// 码长相同的符号按字节值从小到大依次分配编码，解码端只凭码长即可还原编码表。
+// 码长不超过MAX_CODE_LEN，解码时一次查表即可得到符号；只有一种字节时没有编码数据
 class HuffmanComress{
-    // 哈夫曼树节点
+public:
+    static const int MAX_CODE_LEN = 12;
+    static const size_t LENGTH_TABLE_SIZE = 128;
+
+    // 哈夫曼树节点，minChar是子树中最小的字符，用于频率相同时确定合并顺序
     struct HuffmanNode {
         char data;
+        char minChar;
         uint32_t freq;
-        HuffmanNode* left;
-        HuffmanNode* right;
-        HuffmanNode(char d, uint32_t f) : data(d), freq(f), left(nullptr), right(nullptr) {}
+        const HuffmanNode* left;
+        const HuffmanNode* right;
+    };
+
+    // 整棵树的节点放在同一个数组中（n个叶子共2n-1个节点），随数组一起释放
+    struct HuffmanTree {
+        vector<HuffmanNode> nodes;
+        const HuffmanNode* root = nullptr;
     };
-    char getMinChar(const HuffmanNode* node) {
-        if (!node) return 127;  // 最大char值
-        
-        if (!node->left && !node->right) {
-            return node->data;  // 叶子节点返回字符
-        }
-        
-        // 非叶子节点返回左右子树的最小字符
-        char leftMin = getMinChar(node->left);
-        char rightMin = getMinChar(node->right);
-        
-        return min(leftMin, rightMin);
-    }
-
-    HuffmanNode *buildHuffmanTree(const map<char,uint32_t> &freqMap) {
-        // 3. 构建哈夫曼树（使用稳定优先队列）
-        // 自定义优先队列比较器，确保稳定性
-        auto nodeCompare = [this](const HuffmanNode* a, const HuffmanNode* b) {
+
+    // 按频率建树（旧格式解码依赖完全相同的合并顺序）
+    static void buildHuffmanTree(const map<char,uint32_t> &freqMap, HuffmanTree& tree) {
+        tree.nodes.clear();
+        tree.nodes.reserve(freqMap.size() * 2);
+        tree.root = nullptr;
+
+        // 频率相同时比较子树中最小的字符，确保稳定性
+        auto nodeCompare = [](const HuffmanNode* a, const HuffmanNode* b) {
             if (a->freq != b->freq) {
                 return a->freq > b->freq;  // 最小堆
             }
-            // 频率相同时，比较节点中最小字符（确保稳定性）
-            // 需要辅助函数获取节点中的最小字符
-            return getMinChar(a) > getMinChar(b);
+            return a->minChar > b->minChar;
         };
-        
-        priority_queue<HuffmanNode*, vector<HuffmanNode*>, 
+        priority_queue<const HuffmanNode*, vector<const HuffmanNode*>,
                     decltype(nodeCompare)> pq(nodeCompare);
-        
-        // 创建叶子节点并加入优先队列
+
         for (const auto& p : freqMap) {
-            pq.push(new HuffmanNode(p.first, p.second));
+            tree.nodes.push_back({p.first, p.first, p.second, nullptr, nullptr});
+            pq.push(&tree.nodes.back());
         }
-        
-        // 构建哈夫曼树
+
         while (pq.size() > 1) {
-            HuffmanNode* left = pq.top(); pq.pop();
-            HuffmanNode* right = pq.top(); pq.pop();
-            
-            HuffmanNode* parent = new HuffmanNode('\0', left->freq + right->freq);
-            parent->left = left;
-            parent->right = right;
-            
-            pq.push(parent);
+            const HuffmanNode* left = pq.top(); pq.pop();
+            const HuffmanNode* right = pq.top(); pq.pop();
+            tree.nodes.push_back({'\0', min(left->minChar, right->minChar), left->freq + right->freq, left, right});
+            pq.push(&tree.nodes.back());
         }
-        
-        return pq.empty() ? nullptr : pq.top();
+
+        tree.root = pq.empty() ? nullptr : pq.top();
     }
 
-    void freeHuffmanTree(HuffmanNode* root) {
-        if (!root) return;
-        freeHuffmanTree(root->left);
-        freeHuffmanTree(root->right);
-        delete root;
+    // 由码长生成范式编码：码长从短到长、同一码长内按字节值递增分配
+    static void canonicalCodes(const uint8_t lengths[256], uint32_t codes[256]) {
+        uint32_t lengthCount[MAX_CODE_LEN + 1] = {};
+        for (int c = 0; c < 256; c++) lengthCount[lengths[c]]++;
+        lengthCount[0] = 0;
+        uint32_t next[MAX_CODE_LEN + 1] = {};
+        uint32_t code = 0;
+        for (int len = 1; len <= MAX_CODE_LEN; len++) {
+            code = (code + lengthCount[len - 1]) << 1;
+            next[len] = code;
+        }
+        for (int c = 0; c < 256; c++) {
+            if (lengths[c]) codes[c] = next[lengths[c]]++;
+        }
     }
 
-public:
-    bool Compress(const string& srcFile, const string& destFile) {
-        // 1. 统计字符频率（使用map，自动按键排序）
-        ifstream in(srcFile, ios::binary);
-        if (!in.is_open()) return false;
-        
-        map<char, uint32_t> freqMap;  // map会按键自动排序
-        char c;
-        
-        while (in.get(c)) {
-            freqMap[c]++;
-        }
-        in.close();
-        
-        HuffmanNode* root = buildHuffmanTree(freqMap);
-        
-        // 4. 生成哈夫曼编码（使用稳定遍历顺序）
-        unordered_map<char, string> codeMap;
-        
-        function<void(HuffmanNode*, string)> generateCodes = 
-            [&](HuffmanNode* node, string code) {
-            if (!node) return;
-            if (!node->left && !node->right) {
-                codeMap[node->data] = code;
+    // 压缩一块数据。编码表按字节值平铺为256项，编码位在64位累加器中拼接，每满32位整字写出
+    void Compress(const char* data, size_t size, string& out) {
+        uint32_t counts[256] = {};
+        for (size_t i = 0; i < size; i++) {
+            counts[(unsigned char)data[i]]++;
+        }
+
+        uint8_t lengths[256] = {};
+        buildLengths(counts, lengths);
+        uint32_t codes[256] = {};
+        canonicalCodes(lengths, codes);
+
+        // 码长表：每字节两个符号，低4位为偶数字节值
+        size_t distinct = 0;
+        uint64_t totalBits = 0;
+        for (int c = 0; c < 256; c += 2) {
+            out.push_back(char(lengths[c] | (lengths[c + 1] << 4)));
+        }
+        for (int c = 0; c < 256; c++) {
+            if (counts[c]) distinct++;
+            totalBits += uint64_t(counts[c]) * lengths[c];
+        }
+        if (distinct <= 1) return;
+
+        // 编码数据：输出长度可由频率和码长算出，一次分配
+        size_t pos = out.size();
+        out.resize(pos + (totalBits + 7) / 8 + 4);
+        char* dst = &out[pos];
+        uint64_t acc = 0;
+        int bits = 0;
+        for (size_t i = 0; i < size; i++) {
+            unsigned char c = data[i];
+            acc = (acc << lengths[c]) | codes[c];
+            bits += lengths[c];
+            if (bits >= 32) {
+                bits -= 32;
+                uint32_t word = __builtin_bswap32(uint32_t(acc >> bits));
+                memcpy(dst, &word, sizeof(word));
+                dst += sizeof(word);
+            }
+        }
+        // 剩余位补齐到整字节
+        while (bits >= 8) {
+            bits -= 8;
+            *dst++ = char(acc >> bits);
+        }
+        if (bits > 0) {
+            *dst++ = char(acc << (8 - bits));
+        }
+        out.resize(dst - out.data());
+    }
+
+    // 解压一个数据块，追加rawSize字节到out之后
+    static bool Decompress(const char* in, size_t inLen, string& out, size_t rawSize) {
+        if (inLen < LENGTH_TABLE_SIZE) {
+            spdlog::error("哈夫曼数据损坏：缺少码长表");
+            return false;
+        }
+        uint8_t lengths[256];
+        int distinct = 0, last = 0;
+        uint32_t kraft = 0;
+        for (int c = 0; c < 256; c++) {
+            uint8_t b = uint8_t(in[c / 2]);
+            lengths[c] = (c & 1) ? (b >> 4) : (b & 0x0F);
+            if (lengths[c] > MAX_CODE_LEN) {
+                spdlog::error("哈夫曼数据损坏：码长{}", lengths[c]);
+                return false;
+            }
+            if (lengths[c]) {
+                distinct++;
+                last = c;
+                kraft += 1u << (MAX_CODE_LEN - lengths[c]);
+            }
+        }
+        if (kraft > (1u << MAX_CODE_LEN) || (distinct == 0 && rawSize > 0)) {
+            spdlog::error("哈夫曼数据损坏：码长表无效");
+            return false;
+        }
+
+        size_t base = out.size();
+        out.resize(base + rawSize);
+        char* dst = &out[base];
+        if (distinct == 1) {
+            memset(dst, char(last), rawSize);
+            return true;
+        }
+
+        // 单符号查找表，再为剩余位足够的项补上第二个符号
+        struct Entry {
+            uint8_t count = 0;        // 0表示该位模式没有对应的编码
+            uint8_t firstBits = 0;
+            uint8_t totalBits = 0;
+            char symbols[2] = {0, 0};
+        };
+        const uint32_t tableSize = 1u << MAX_CODE_LEN;
+        vector<Entry> table(tableSize);
+        uint32_t codes[256] = {};
+        canonicalCodes(lengths, codes);
+        for (int c = 0; c < 256; c++) {
+            if (!lengths[c]) continue;
+            int shift = MAX_CODE_LEN - lengths[c];
+            for (uint32_t i = codes[c] << shift; i < (codes[c] + 1) << shift; i++) {
+                table[i].count = 1;
+                table[i].firstBits = table[i].totalBits = lengths[c];
+                table[i].symbols[0] = char(c);
+            }
+        }
+        for (uint32_t i = 0; i < tableSize; i++) {
+            Entry& e = table[i];
+            if (e.count == 0) continue;
+            const Entry& second = table[(i << e.firstBits) & (tableSize - 1)];
+            if (second.count && second.firstBits <= MAX_CODE_LEN - e.firstBits) {
+                e.count = 2;
+                e.symbols[1] = second.symbols[0];
+                e.totalBits = e.firstBits + second.firstBits;
+            }
+        }
+
+        // 64位位缓冲，下一个待读的位在最高位；输入末尾之后补0
+        const char* p = in + LENGTH_TABLE_SIZE;
+        const char* end = in + inLen;
+        uint64_t bitBuf = 0;
+        int bitCount = 0;
+        size_t remaining = rawSize;
+
+        // 快速路径：装满位缓冲后连续查表4次，每次最多MAX_CODE_LEN位、2个符号
+        while (remaining >= 8 && end - p >= 8) {
+            uint64_t v;
+            memcpy(&v, p, sizeof(v));
+            bitBuf |= __builtin_bswap64(v) >> bitCount;
+            p += (63 - bitCount) >> 3;
+            bitCount |= 56;
+            for (int k = 0; k < 4; k++) {
+                const Entry& e = table[bitBuf >> (64 - MAX_CODE_LEN)];
+                if (e.count == 0) {
+                    spdlog::error("哈夫曼数据损坏：无效编码");
+                    return false;
+                }
+                dst[0] = e.symbols[0];
+                dst[1] = e.symbols[1];
+                dst += e.count;
+                remaining -= e.count;
+                bitBuf <<= e.totalBits;
+                bitCount -= e.totalBits;
+            }
+        }
+
+        while (remaining > 0) {
+            while (bitCount <= 56 && p < end) {
+                bitBuf |= uint64_t(uint8_t(*p++)) << (56 - bitCount);
+                bitCount += 8;
+            }
+            const Entry& e = table[bitBuf >> (64 - MAX_CODE_LEN)];
+            if (e.count == 0 || e.firstBits > bitCount) {
+                spdlog::error("哈夫曼数据损坏：编码数据不完整");
+                return false;
+            }
+            *dst++ = e.symbols[0];
+            remaining--;
+            bitBuf <<= e.firstBits;
+            bitCount -= e.firstBits;
+        }
+        return true;
+    }
+
+private:
+    // 由频率计算码长。超过MAX_CODE_LEN时把频率减半（出现过的符号至少保留1）后重建，
+    // 直到最长编码不超过上限。合并顺序与buildHuffmanTree相同，但节点放在栈上的定长数组中：
+    // 前n项为叶子，内部节点依次追加，子节点总在父节点之前，从根向前扫一遍即得到各节点深度
+    static void buildLengths(const uint32_t counts[256], uint8_t lengths[256]) {
+        const size_t kMaxNodes = 511;
+        uint32_t freq[kMaxNodes];
+        char minChar[kMaxNodes];
+        uint16_t parent[kMaxNodes];
+        uint8_t depth[kMaxNodes];
+        uint8_t symbols[256];
+        uint32_t leafFreq[256];
+        size_t leaves = 0;
+        for (int c = 0; c < 256; c++) {
+            if (counts[c]) {
+                symbols[leaves] = uint8_t(c);
+                leafFreq[leaves++] = counts[c];
+            }
+        }
+        if (leaves == 0) return;
+        if (leaves == 1) {
+            lengths[symbols[0]] = 1;
+            return;
+        }
+
+        // 频率相同时比较子树中最小的字符（与buildHuffmanTree一致，char按有符号比较）
+        auto greater = [&](uint16_t a, uint16_t b) {
+            if (freq[a] != freq[b]) return freq[a] > freq[b];
+            return minChar[a] > minChar[b];
+        };
+        uint16_t heap[256];
+        while (true) {
+            size_t heapSize = 0;
+            for (size_t i = 0; i < leaves; i++) {
+                freq[i] = leafFreq[i];
+                minChar[i] = char(symbols[i]);
+                heap[heapSize++] = uint16_t(i);
+            }
+            make_heap(heap, heap + heapSize, greater);
+
+            size_t count = leaves;
+            while (heapSize > 1) {
+                pop_heap(heap, heap + heapSize--, greater);
+                uint16_t left = heap[heapSize];
+                pop_heap(heap, heap + heapSize--, greater);
+                uint16_t right = heap[heapSize];
+                freq[count] = freq[left] + freq[right];
+                minChar[count] = min(minChar[left], minChar[right]);
+                parent[left] = parent[right] = uint16_t(count);
+                heap[heapSize++] = uint16_t(count);
+                push_heap(heap, heap + heapSize, greater);
+                count++;
+            }
+
+            size_t root = count - 1;
+            depth[root] = 0;
+            int maxLen = 0;
+            for (size_t i = root; i-- > 0;) {
+                depth[i] = uint8_t(depth[parent[i]] + 1);
+                if (i < leaves) maxLen = max<int>(maxLen, depth[i]);
+            }
+            if (maxLen <= MAX_CODE_LEN) {
+                for (size_t i = 0; i < leaves; i++) lengths[symbols[i]] = depth[i];
                 return;
             }
-            // 确保遍历顺序：总是先左后右
-            generateCodes(node->left, code + "0");
-            generateCodes(node->right, code + "1");
+            for (size_t i = 0; i < leaves; i++) leafFreq[i] = (leafFreq[i] >> 1) | 1;
+        }
+    }
+};
+
+// rANS格式（kBlockANS）：频率表 | 4个状态的初值(各4字节，小端) | 编码数据(16位小端字)
+// 频率表为每个字节值4位的频率位数（0表示未出现，布局与范式哈夫曼的码长表相同，共128字节），
+// 之后按字节值顺序拼接各频率去掉最高位1后的低位（高位在前，末尾补0到整字节）。
+// 频率归一化到总和PROB_SCALE，符号可以占小数位，分布很偏时比哈夫曼（每个符号至少1位）更接近熵。
+// 相邻符号轮流使用4个状态编码，解码时4条依赖链互不等待，可以交错执行。
+// 状态保持在[RANS_L, RANS_L << 16)，每个符号编解码时最多移出/补入一个16位字，解码无需循环和分支。
+// 编码从最后一个符号向前进行，字从缓冲末尾向前写出，解码从前向后读；只有一种字节时没有后续数据
+class RansCompress {
+public:
+    static const int PROB_BITS = 12;
+    static const uint32_t PROB_SCALE = 1u << PROB_BITS;
+    static const uint32_t RANS_L = 1u << 15;   // 状态的下界，上界为2^31（编码的倒数乘法要求）
+    static const int STATES = 4;
+    static const size_t WIDTH_TABLE_SIZE = 128;
+
+    void Compress(const char* data, size_t size, string& out) {
+        uint32_t counts[256] = {};
+        for (size_t i = 0; i < size; i++) {
+            counts[(unsigned char)data[i]]++;
+        }
+        uint32_t freqs[256] = {};
+        normalize(counts, size, freqs);
+
+        // 频率表：罕见字节的频率很小，只占几位
+        uint8_t widths[256] = {};
+        size_t distinct = 0;
+        for (int c = 0; c < 256; c++) {
+            if (!freqs[c]) continue;
+            widths[c] = uint8_t(32 - __builtin_clz(freqs[c]));
+            distinct++;
+        }
+        for (int c = 0; c < 256; c += 2) {
+            out.push_back(char(widths[c] | (widths[c + 1] << 4)));
+        }
+        uint64_t acc = 0;
+        int bits = 0;
+        for (int c = 0; c < 256; c++) {
+            if (widths[c] <= 1) continue;
+            acc = (acc << (widths[c] - 1)) | (freqs[c] & ((1u << (widths[c] - 1)) - 1));
+            bits += widths[c] - 1;
+            while (bits >= 8) {
+                bits -= 8;
+                out.push_back(char(acc >> bits));
+            }
+        }
+        if (bits > 0) out.push_back(char(acc << (8 - bits)));
+        if (distinct <= 1) return;
+
+        // 编码参数：用预先算好的倒数乘法代替除以频率（状态小于2^31时结果精确）
+        EncSymbol symbols[256];
+        uint32_t start = 0;
+        for (int c = 0; c < 256; c++) {
+            if (!freqs[c]) continue;
+            initSymbol(symbols[c], start, freqs[c]);
+            start += freqs[c];
+        }
+
+        // 每个符号的输出不超过2字节，另留出状态初值和最后一次预写的位置
+        string buf(size * 2 + STATES * 4 + 2, '\0');
+        uint8_t* end = reinterpret_cast<uint8_t*>(&buf[0]) + buf.size();
+        uint8_t* ptr = end;
+        // 移出的字总是先写在ptr之前，只在需要移出时才移动ptr，避免难以预测的分支
+        auto encode = [&symbols, &ptr](uint32_t& x, char c) {
+            const EncSymbol& sym = symbols[(unsigned char)c];
+            uint32_t shift = x >= sym.xMax;
+            uint16_t word = uint16_t(x);
+            memcpy(ptr - 2, &word, sizeof(word));
+            ptr -= shift * 2;
+            x >>= shift * 16;
+            uint32_t q = uint32_t((uint64_t(x) * sym.rcpFreq) >> 32) >> sym.rcpShift;
+            x += sym.bias + q * sym.cmplFreq;
+        };
+
+        // 第i个符号用第i % STATES个状态。先编码末尾不足一轮的符号，之后每轮4个
+        uint32_t state[STATES];
+        for (auto& x : state) x = RANS_L;
+        size_t i = size;
+        while (i % STATES) {
+            i--;
+            encode(state[i % STATES], data[i]);
+        }
+        uint32_t x0 = state[0], x1 = state[1], x2 = state[2], x3 = state[3];
+        while (i > 0) {
+            i -= STATES;
+            encode(x3, data[i + 3]);
+            encode(x2, data[i + 2]);
+            encode(x1, data[i + 1]);
+            encode(x0, data[i]);
+        }
+        for (uint32_t x : {x3, x2, x1, x0}) {
+            ptr -= 4;
+            memcpy(ptr, &x, sizeof(x));
+        }
+        out.append(reinterpret_cast<const char*>(ptr), end - ptr);
+    }
+
+    // 解压一个数据块，追加rawSize字节到out之后
+    static bool Decompress(const char* in, size_t inLen, string& out, size_t rawSize) {
+        if (inLen < WIDTH_TABLE_SIZE) {
+            spdlog::error("rANS数据损坏：缺少频率表");
+            return false;
+        }
+        uint8_t widths[256];
+        size_t lowBits = 0;
+        for (int c = 0; c < 256; c++) {
+            uint8_t b = uint8_t(in[c / 2]);
+            widths[c] = (c & 1) ? (b >> 4) : (b & 0x0F);
+            if (widths[c] > PROB_BITS + 1) {
+                spdlog::error("rANS数据损坏：频率表无效");
+                return false;
+            }
+            if (widths[c] > 1) lowBits += widths[c] - 1;
+        }
+        size_t ip = WIDTH_TABLE_SIZE + (lowBits + 7) / 8;
+        if (ip > inLen) {
+            spdlog::error("rANS数据损坏：缺少频率表");
+            return false;
+        }
+
+        uint32_t freqs[256] = {};
+        uint32_t total = 0;
+        int distinct = 0, last = 0;
+        size_t bitPos = WIDTH_TABLE_SIZE * 8;
+        for (int c = 0; c < 256; c++) {
+            if (!widths[c]) continue;
+            uint32_t f = 1;
+            for (int b = 1; b < widths[c]; b++, bitPos++) {
+                f = (f << 1) | ((uint8_t(in[bitPos / 8]) >> (7 - bitPos % 8)) & 1);
+            }
+            freqs[c] = f;
+            total += f;
+            distinct++;
+            last = c;
+        }
+        if (distinct == 0 ? rawSize > 0 : total != PROB_SCALE) {
+            spdlog::error("rANS数据损坏：频率表无效");
+            return false;
+        }
+
+        size_t base = out.size();
+        out.resize(base + rawSize);
+        char* dst = &out[base];
+        if (distinct <= 1) {
+            memset(dst, char(last), rawSize);
+            return true;
+        }
+
+        // 状态的低PROB_BITS位落在哪个符号的区间，就解出哪个符号。
+        // 每项32位：频率(高12位，至少两种字节时不超过PROB_SCALE-1) | 在区间内的位置(12位) | 字节值(8位)
+        vector<uint32_t> table(PROB_SCALE);
+        uint32_t start = 0;
+        for (int c = 0; c < 256; c++) {
+            for (uint32_t i = 0; i < freqs[c]; i++) {
+                table[start + i] = freqs[c] << 20 | i << 8 | uint32_t(c);
+            }
+            start += freqs[c];
+        }
+
+        const uint8_t* p = reinterpret_cast<const uint8_t*>(in) + ip;
+        const uint8_t* end = reinterpret_cast<const uint8_t*>(in) + inLen;
+        if (size_t(end - p) < STATES * 4) {
+            spdlog::error("rANS数据损坏：编码数据不完整");
+            return false;
+        }
+        uint32_t state[STATES];
+        for (auto& x : state) {
+            x = uint32_t(p[0]) | uint32_t(p[1]) << 8 | uint32_t(p[2]) << 16 | uint32_t(p[3]) << 24;
+            p += 4;
+            // 状态在[RANS_L, 2^31)内时，每个符号解码后补读一个字就能回到该范围
+            if (x < RANS_L || x >= (RANS_L << 16)) {
+                spdlog::error("rANS数据损坏：状态无效");
+                return false;
+            }
+        }
+
+        // 写dst（char*）可能与任何内存重叠，查找表指针和状态放在局部变量中，避免每次写后重新读取
+        const uint32_t* slots = table.data();
+        auto decode = [slots](uint32_t& x) {
+            uint32_t e = slots[x & (PROB_SCALE - 1)];
+            x = (e >> 20) * (x >> PROB_BITS) + ((e >> 8) & (PROB_SCALE - 1));
+            return char(e);
         };
-        
-        generateCodes(root, "");
-        
-        // 5. 写入压缩文件（保持写入顺序稳定）
-        ofstream out(destFile, ios::binary);
-        
-        // 先写入字符数量
-        uint32_t charCount = freqMap.size();
-        out.write((char*)&charCount, sizeof(charCount));
-        
-        // 按排序后的顺序写入字符和频率
-        for (auto [ch,freq] : freqMap) {
-            out.write(&ch, 1);
-            out.write((char*)&freq, sizeof(freq));
-        }
-        
-        // 6. 编码数据并写入
-        in.open(srcFile, ios::binary);
-        char buf = 0;
-        int bitPos = 0;
-        
-        while (in.get(c)) {
-            string code = codeMap[c];
-            for (char bit : code) {
-                buf = (buf << 1) | (bit - '0');
-                bitPos++;
-                if (bitPos == 8) {
-                    out.write(&buf, 1);
-                    buf = 0;
-                    bitPos = 0;
+        auto readWord = [](const uint8_t* in) {
+            uint16_t word;
+            memcpy(&word, in, sizeof(word));
+            return uint32_t(word);
+        };
+
+        // 快速路径：每轮4个状态各解一个符号，输入足够时无分支地补读，不检查边界。
+        // 先算出各状态补读的位置，4次读取互不依赖
+        size_t i = 0;
+        uint32_t x0 = state[0], x1 = state[1], x2 = state[2], x3 = state[3];
+        const uint8_t* q = p;
+        while (rawSize - i >= STATES && size_t(end - q) >= STATES * 2) {
+            dst[i] = decode(x0);
+            dst[i + 1] = decode(x1);
+            dst[i + 2] = decode(x2);
+            dst[i + 3] = decode(x3);
+            uint32_t l0 = x0 < RANS_L, l1 = x1 < RANS_L, l2 = x2 < RANS_L, l3 = x3 < RANS_L;
+            const uint8_t* q1 = q + l0 * 2;
+            const uint8_t* q2 = q1 + l1 * 2;
+            const uint8_t* q3 = q2 + l2 * 2;
+            x0 = (x0 << (l0 * 16)) | (readWord(q) & (0u - l0));
+            x1 = (x1 << (l1 * 16)) | (readWord(q1) & (0u - l1));
+            x2 = (x2 << (l2 * 16)) | (readWord(q2) & (0u - l2));
+            x3 = (x3 << (l3 * 16)) | (readWord(q3) & (0u - l3));
+            q = q3 + l3 * 2;
+            i += STATES;
+        }
+        state[0] = x0;
+        state[1] = x1;
+        state[2] = x2;
+        state[3] = x3;
+        p = q;
+        for (; i < rawSize; i++) {
+            uint32_t& x = state[i % STATES];
+            dst[i] = decode(x);
+            if (x < RANS_L) {
+                if (end - p < 2) {
+                    spdlog::error("rANS数据损坏：编码数据不完整");
+                    return false;
                 }
+                x = (x << 16) | uint32_t(p[0]) | uint32_t(p[1]) << 8;
+                p += 2;
             }
         }
-        
-        // 处理剩余位
-        if (bitPos > 0) {
-            buf <<= (8 - bitPos);
-            out.write(&buf, 1);
-            // 写入最后一个字节的有效位数
-            out.write((char*)&bitPos, 1);
+
+        // 编码从初始状态开始，正确的数据解码完恰好回到初始状态并读完所有字节
+        bool consistent = p == end;
+        for (uint32_t x : state) consistent = consistent && x == RANS_L;
+        if (!consistent) {
+            spdlog::error("rANS数据损坏：编码数据不一致");
+            return false;
+        }
+        return true;
+    }
+
+private:
+    struct EncSymbol {
+        uint32_t xMax;       // 编码前状态需小于此值，否则先移出低16位
+        uint32_t rcpFreq;    // 1/freq的定点倒数
+        uint32_t rcpShift;
+        uint32_t bias;
+        uint32_t cmplFreq;   // PROB_SCALE - freq
+    };
+
+    // x' = (x / freq) * PROB_SCALE + x % freq + start，写成 x + bias + q * cmplFreq，q = x / freq
+    static void initSymbol(EncSymbol& sym, uint32_t start, uint32_t freq) {
+        sym.xMax = ((RANS_L >> PROB_BITS) << 16) * freq;
+        sym.cmplFreq = PROB_SCALE - freq;
+        if (freq < 2) {
+            // freq为1时q = x，用全1倒数得到x - 1，差的1并入bias
+            sym.rcpFreq = ~0u;
+            sym.rcpShift = 0;
+            sym.bias = start + PROB_SCALE - 1;
         } else {
-            // 如果刚好是8的倍数，写入0表示没有剩余位
-            char zero = 8;
-            out.write(&zero, 1);
-        }
-        
-        in.close();
-        out.close();
-        
-        // 释放哈夫曼树
-        freeHuffmanTree(root);
+            uint32_t shift = 0;
+            while (freq > (1u << shift)) shift++;
+            sym.rcpFreq = uint32_t(((uint64_t(1) << (shift + 31)) + freq - 1) / freq);
+            sym.rcpShift = shift - 1;
+            sym.bias = start;
+        }
+    }
+
+    // 频率按比例缩放到总和PROB_SCALE，出现过的字节至少为1。舍入误差由最常见的字节吸收，
+    // 它不够吸收时（大量罕见字节都被抬到1）从其余频率大于1的字节依次各减1
+    static void normalize(const uint32_t counts[256], size_t total, uint32_t freqs[256]) {
+        if (total == 0) return;
+        int maxSym = 0;
+        int64_t sum = 0;
+        for (int c = 0; c < 256; c++) {
+            if (!counts[c]) continue;
+            uint64_t f = (uint64_t(counts[c]) * PROB_SCALE + total / 2) / total;
+            freqs[c] = uint32_t(max<uint64_t>(f, 1));
+            sum += freqs[c];
+            if (counts[c] > counts[maxSym]) maxSym = c;
+        }
+        int64_t diff = int64_t(PROB_SCALE) - sum;
+        if (diff >= 0 || int64_t(freqs[maxSym]) > -diff * 4) {
+            freqs[maxSym] = uint32_t(freqs[maxSym] + diff);
+            return;
+        }
+        while (diff < 0) {
+            for (int c = 0; c < 256 && diff < 0; c++) {
+                if (freqs[c] > 1) {
+                    freqs[c]--;
+                    diff++;
+                }
+            }
+        }
+    }
+};
+
+// LZ77 + 熵编码：LZ77序列拆成token、字面量、变长字段三个串，各自用Coder编码
+// （kBlockLZH为范式哈夫曼，kBlockLZA为rANS）。每个串为 原始长度(varint) | 编码长度(varint) | 数据，
+// 两个长度相等表示原样存储（熵编码无效或串为空）
+template <class Coder>
+class LZEntropyCompress {
+public:
+    static void Compress(const char* buf, size_t historyLen, size_t size, int level, string& out) {
+        string tokens, literals, extras;
+        LZ77Compress::SeqOutput seq{tokens, literals, extras};
+        LZ77Compress lz77(level);
+        lz77.Compress(buf, historyLen, size, seq);
+        for (const string* stream : {&tokens, &literals, &extras}) {
+            appendStream(*stream, out);
+        }
+    }
+
+    static bool Decompress(const char* in, size_t inLen, string& window, size_t historyLen, size_t rawSize) {
+        string streams[3];
+        size_t ip = 0;
+        for (auto& stream : streams) {
+            if (!readStream(in, inLen, ip, stream)) {
+                spdlog::error("LZ77序列数据损坏：熵编码串无效");
+                return false;
+            }
+        }
+        if (ip != inLen) {
+            spdlog::error("LZ77序列数据损坏：熵编码串无效");
+            return false;
+        }
+        size_t pos[3] = {0, 0, 0};
+        LZ77Compress::SeqInput tokens{streams[0].data(), streams[0].size(), pos[0]};
+        LZ77Compress::SeqInput literals{streams[1].data(), streams[1].size(), pos[1]};
+        LZ77Compress::SeqInput extras{streams[2].data(), streams[2].size(), pos[2]};
+        return LZ77Compress::Decompress(tokens, literals, extras, window, historyLen, rawSize);
+    }
+
+private:
+    static void appendStream(const string& raw, string& out) {
+        string packed;
+        bool stored = raw.empty() || looksIncompressible(raw.data(), raw.size());
+        if (!stored) {
+            Coder coder;
+            coder.Compress(raw.data(), raw.size(), packed);
+            stored = packed.size() >= raw.size();
+        }
+        putVarint(out, raw.size());
+        putVarint(out, stored ? raw.size() : packed.size());
+        out.append(stored ? raw : packed);
+    }
+
+    static bool readStream(const char* in, size_t inLen, size_t& ip, string& out) {
+        uint64_t rawSize, packedSize;
+        if (!getVarint(in, inLen, ip, rawSize) || !getVarint(in, inLen, ip, packedSize)) return false;
+        if (packedSize > inLen - ip || rawSize > kMaxBlockBytes) return false;
+        const char* data = in + ip;
+        ip += packedSize;
+        if (packedSize == rawSize) {
+            out.assign(data, packedSize);
+            return true;
+        }
+        return Coder::Decompress(data, packedSize, out, rawSize);
+    }
+};
+
+using LZHCompress = LZEntropyCompress<HuffmanComress>;
+using LZACompress = LZEntropyCompress<RansCompress>;
+
+// 哈夫曼增量解码器（旧格式文件与kBlockHaff数据块共用）
+// 频率之和就是原始字节数，解码到该数量即停止，末尾的填充位和有效位数字节无需特殊处理。
+// 建树后展开为TABLE_BITS位的查找表：一次查表解出一个或两个符号，
+// 更长的编码（低频符号）查表后再沿树逐位走完
+class HuffmanDecoder {
+public:
+    explicit HuffmanDecoder(ByteSink& out) : m_out(out), m_buf(kStreamChunkSize) {}
+
+    bool feed(const char* data, size_t len) {
+        size_t i = 0;
+        if (!m_headerDone) {
+            i = readHeader(data, len);
+            if (m_failed) return false;
+            if (!m_headerDone) return true;
+        }
+        return decode(data + i, len - i);
+    }
+
+    // 输入结束：校验数据完整并写出剩余数据（不结束下游）
+    bool finish() {
+        if (!m_headerDone || m_remaining > 0) {
+            spdlog::error("哈夫曼数据不完整");
+            return false;
+        }
+        return flush();
+    }
+
+    uint64_t produced() const { return m_produced; }
+
+private:
+    static const int TABLE_BITS = 11;
+
+    // 查找表项：count为0表示编码长于TABLE_BITS，需从node继续逐位解码
+    struct TableEntry {
+        uint8_t count = 0;        // 本项解出的符号数（1或2）
+        uint8_t firstBits = 0;    // 第一个符号的编码长度
+        uint8_t totalBits = 0;    // 全部符号的编码长度之和
+        char symbols[2] = {0, 0};
+        const HuffmanComress::HuffmanNode* node = nullptr;
+    };
+
+    static bool isLeaf(const HuffmanComress::HuffmanNode* n) { return !n->left && !n->right; }
+
+    void buildTable() {
+        m_table.assign(size_t(1) << TABLE_BITS, TableEntry());
+        for (uint32_t index = 0; index < m_table.size(); index++) {
+            TableEntry& e = m_table[index];
+            const HuffmanComress::HuffmanNode* node = m_root;
+            int bit = TABLE_BITS - 1;
+            // 第一个符号
+            while (bit >= 0 && !isLeaf(node)) {
+                node = ((index >> bit--) & 1) ? node->right : node->left;
+            }
+            if (!isLeaf(node)) {
+                e.node = node;
+                continue;
+            }
+            e.count = 1;
+            e.symbols[0] = node->data;
+            e.firstBits = e.totalBits = uint8_t(TABLE_BITS - 1 - bit);
+            // 剩余位数足够时再解一个符号
+            node = m_root;
+            int start = bit;
+            while (bit >= 0 && !isLeaf(node)) {
+                node = ((index >> bit--) & 1) ? node->right : node->left;
+            }
+            if (isLeaf(node) && bit < start) {
+                e.count = 2;
+                e.symbols[1] = node->data;
+                e.totalBits = uint8_t(TABLE_BITS - 1 - bit);
+            }
+        }
+    }
+
+    // 至少还有8字节输入时一次装满：读入8字节，按已有位数对齐，多读的位是之后的真实数据，
+    // 下次装入时与同样的位再次相或，不影响结果
+    void refillFast(const char*& p) {
+        uint64_t v;
+        memcpy(&v, p, sizeof(v));
+        m_bitBuf |= __builtin_bswap64(v) >> m_bitCount;
+        p += (63 - m_bitCount) >> 3;
+        m_bitCount |= 56;
+    }
+
+    // 64位位缓冲：下一个待读的位在最高位，输入末尾之后全部为0
+    void refill(const char*& p, const char* end) {
+        while (m_bitCount <= 56 && p < end) {
+            m_bitBuf |= uint64_t(uint8_t(*p++)) << (56 - m_bitCount);
+            m_bitCount += 8;
+        }
+    }
+
+    void consume(int n) {
+        m_bitBuf <<= n;
+        m_bitCount -= n;
+    }
+
+    void emit(char c) {
+        m_buf[m_bufLen++] = c;
+        m_remaining--;
+    }
+
+    bool decode(const char* data, size_t len) {
+        const char* p = data;
+        const char* end = data + len;
+
+        // 快速路径：每次装满位缓冲后连续查表4次（每次最多11位、2个符号）
+        while (m_curr == m_root && m_remaining >= 8 && end - p >= 8) {
+            if (m_bufLen + 8 > m_buf.size() && !flush()) return false;
+            refillFast(p);
+            for (int k = 0; k < 4; k++) {
+                const TableEntry& e = m_table[m_bitBuf >> (64 - TABLE_BITS)];
+                if (e.count == 0) {
+                    consume(TABLE_BITS);
+                    m_curr = e.node;
+                    walkTree();
+                    break;
+                }
+                m_buf[m_bufLen] = e.symbols[0];
+                m_buf[m_bufLen + 1] = e.symbols[1];
+                m_bufLen += e.count;
+                m_remaining -= e.count;
+                consume(e.totalBits);
+            }
+        }
+
+        while (m_remaining > 0) {
+            if (m_bufLen + 2 > m_buf.size() && !flush()) return false;
+            refill(p, end);
+
+            // 上次输入（或位缓冲）在长编码中途用完，继续沿树逐位解码
+            if (m_curr != m_root) {
+                if (!walkTree() && p == end) break;
+                continue;
+            }
+
+            const TableEntry& e = m_table[m_bitBuf >> (64 - TABLE_BITS)];
+            if (e.count == 0) {
+                if (m_bitCount < TABLE_BITS) break;    // 等待更多输入
+                consume(TABLE_BITS);
+                m_curr = e.node;
+                if (!walkTree() && p == end) break;
+            } else if (e.count == 2 && e.totalBits <= m_bitCount && m_remaining >= 2) {
+                emit(e.symbols[0]);
+                emit(e.symbols[1]);
+                consume(e.totalBits);
+            } else if (e.firstBits <= m_bitCount) {
+                emit(e.symbols[0]);
+                consume(e.firstBits);
+            } else {
+                break;                                  // 等待更多输入
+            }
+        }
+        // 剩余的输入只可能是填充位和有效位数字节
+        return flush();
+    }
+
+    // 从m_curr逐位走到叶子，位不够时返回false并保留m_curr
+    bool walkTree() {
+        while (!isLeaf(m_curr)) {
+            if (m_bitCount == 0) return false;
+            m_curr = (m_bitBuf >> 63) ? m_curr->right : m_curr->left;
+            consume(1);
+        }
+        emit(m_curr->data);
+        m_curr = m_root;
         return true;
     }
-    // 哈夫曼解压
-    bool Decompress(const string& compressFile, const string& destFile) {
-        ifstream in(compressFile, ios::binary);
-        ofstream out(destFile, ios::binary);
-        if (!in.is_open() || !out.is_open()) return false;
-        
-        // 1. 读取频率表
-        uint32_t charCount = 0;
-        in.read((char*)&charCount, sizeof(charCount));
-        
+
+    // 读取频率表并建树，返回已消费的字节数
+    size_t readHeader(const char* data, size_t len) {
+        size_t used = 0;
+        size_t need = 4;
+        if (m_header.size() >= 4) need = 4 + getU32(m_header.data()) * 5;
+        while (used < len && m_header.size() < need) {
+            size_t n = min(len - used, need - m_header.size());
+            m_header.append(data + used, n);
+            used += n;
+            if (m_header.size() == 4) {
+                uint32_t charCount = getU32(m_header.data());
+                if (charCount > 256) {
+                    spdlog::error("哈夫曼数据损坏：字符数量{}", charCount);
+                    m_failed = true;
+                    return used;
+                }
+                need = 4 + charCount * 5;
+            }
+        }
+        if (m_header.size() < need) return used;
+
         map<char, uint32_t> freqMap;  // 使用map保持顺序
-        for (uint32_t i = 0; i < charCount; i++) {
-            char ch;
-            uint32_t freq;
-            in.read(&ch, 1);
-            in.read((char*)&freq, sizeof(freq));
-            freqMap[ch] = freq;
-        }
-        
-        HuffmanNode* root = buildHuffmanTree(freqMap);
-        
-        // 3. 解码数据
-        HuffmanNode* curr = root;
-        char buf;
-        
-        // 读取最后一个字节的填充位数
-        in.seekg(-1, ios::end);
-        char paddingBits;
-        in.read(&paddingBits, 1);
-        in.seekg(sizeof(uint32_t) + charCount * (1 + sizeof(uint32_t)));
-        
-        streampos dataStart = in.tellg();
-        streampos dataEnd = in.tellg();
-        in.seekg(0, ios::end);
-        streampos fileEnd = in.tellg();
-        
-        // 计算数据字节数
-        long long dataBytes = fileEnd - dataEnd - 1;
-        in.seekg(dataStart);
-        
-        for (long long i = 0; i < dataBytes; i++) {
-            in.read(&buf, 1);
-            int bitsToProcess = (i == dataBytes - 1) ? paddingBits : 8;
-            
-            for (int j = 7; j >= (8 - bitsToProcess); j--) {
-                bool bit = (buf >> j) & 1;
-                curr = bit ? curr->right : curr->left;
-                
-                if (!curr->left && !curr->right) {
-                    out.write(&curr->data, 1);
-                    curr = root;
+        uint64_t total = 0;
+        for (size_t p = 4; p < need; p += 5) {
+            uint32_t freq = getU32(m_header.data() + p + 1);
+            freqMap[m_header[p]] = freq;
+            total += freq;
+        }
+        HuffmanComress::buildHuffmanTree(freqMap, m_tree);
+        m_root = m_tree.root;
+        m_curr = m_root;
+        m_remaining = total;
+        m_headerDone = true;
+        if (!m_root) return used;
+
+        // 只有一种字符时编码长度为0，直接按频率输出
+        if (isLeaf(m_root)) {
+            while (m_remaining > 0) {
+                size_t n = min<uint64_t>(m_remaining, m_buf.size());
+                memset(m_buf.data(), m_root->data, n);
+                m_bufLen = n;
+                m_remaining -= n;
+                if (!flush()) {
+                    m_failed = true;
+                    break;
                 }
             }
+            return used;
+        }
+        buildTable();
+        return used;
+    }
+
+    bool flush() {
+        if (m_bufLen == 0) return true;
+        m_produced += m_bufLen;
+        bool ok = m_out.write(m_buf.data(), m_bufLen);
+        m_bufLen = 0;
+        return ok;
+    }
+
+    ByteSink& m_out;
+    string m_header;
+    bool m_headerDone = false;
+    bool m_failed = false;
+    HuffmanComress::HuffmanTree m_tree;
+    const HuffmanComress::HuffmanNode* m_root = nullptr;
+    const HuffmanComress::HuffmanNode* m_curr = nullptr;
+    vector<TableEntry> m_table;
+    uint64_t m_bitBuf = 0;
+    int m_bitCount = 0;
+    uint64_t m_remaining = 0;
+    uint64_t m_produced = 0;
+    vector<char> m_buf;           // 解码输出缓冲
+    size_t m_bufLen = 0;
+};
+
+
+// 流式压缩阶段：输入按固定大小分块（LZ77/LZH/LZA为kStreamChunkSize，哈夫曼/rANS为kHaffBlockSize），
+// 压缩后不比原始数据小的块原样存储。
+// 每块只依赖原始数据（LZ77的历史窗口也是原始数据），可以在线程池中同时压缩多块，
+// 压缩完成后按顺序写入下游，输出与单线程完全相同。
+// 内存占用为m_maxInFlight个任务，每个任务为历史窗口（不超过压缩级别的窗口大小）+ 一个数据块
+class CompressSink : public ByteSink {
+public:
+    // dictionary非空时固定放在LZ77/LZH每块历史窗口的最前面（哈夫曼/rANS忽略），并写入压缩数据供解压使用
+    CompressSink(uint8_t method, ByteSink& next, int level, size_t threadCount, const string& dictionary)
+        : m_method(method), m_next(next), m_level(level),
+          m_historySize(method == kBlockLZSeq || method == kBlockLZH || method == kBlockLZA
+                        ? LZ77Compress::windowSize(level) : 0),
+          m_blockSize(m_historySize > 0 ? kStreamChunkSize : kHaffBlockSize),
+          m_maxInFlight(threadCount * 2), m_jobs(m_maxInFlight) {
+        m_window.reserve(m_historySize + m_blockSize);
+        if (m_historySize > 0 && !dictionary.empty()) {
+            // 字典在前，最近的数据离当前块更近
+            m_dictionary = dictionary.substr(dictionary.size() - min(dictionary.size(), maxDictSize(m_historySize)));
+            m_historySize -= m_dictionary.size();
+        }
+        if (threadCount > 1) {
+            for (size_t i = 0; i < threadCount; i++) {
+                m_workers.emplace_back(&CompressSink::run, this);
+            }
+        }
+    }
+
+    ~CompressSink() override {
+        m_jobs.close();
+        for (auto& worker : m_workers) worker.join();
+    }
+
+    bool write(const char* data, size_t len) override {
+        while (len > 0) {
+            size_t n = min(len, m_blockSize - blockSize());
+            m_window.append(data, n);
+            data += n;
+            len -= n;
+            if (blockSize() == m_blockSize && !flushBlock()) return false;
+        }
+        return true;
+    }
+
+    bool finish() override {
+        if (blockSize() > 0 && !flushBlock()) return false;
+        while (!m_pending.empty()) {
+            if (!writeFront()) return false;
+        }
+        if (!writeHeader()) return false;
+        string end;
+        appendBlockHeader(end, kBlockEnd, 0, 0, 0);
+        return m_next.write(end.data(), end.size()) && m_next.finish();
+    }
+
+private:
+    // 一个数据块的压缩任务
+    struct Job {
+        string input;           // 历史窗口 + 本块原始数据
+        size_t historyLen = 0;
+        string packed;          // 块头 + 压缩数据
+        string literal;         // LZH/LZA块只做熵编码的结果
+        bool ok = false;
+        promise<void> done;
+        future<void> result;
+    };
+
+    size_t blockSize() const { return m_window.size() - m_historyLen; }
+
+    bool writeHeader() {
+        if (m_headerWritten) return true;
+        m_headerWritten = true;
+        string header(kMagic, sizeof(kMagic));
+        header.push_back(char(kFormatVersion));
+        header.push_back(char(m_method));
+        if (!m_dictionary.empty()) {
+            // 字典本身也按序列格式压缩，压缩后不变小时原样存储（压缩长度等于原始长度）
+            string packed;
+            LZ77Compress lz77(m_level);
+            lz77.Compress(m_dictionary.data(), 0, m_dictionary.size(), packed);
+            if (packed.size() >= m_dictionary.size()) packed = m_dictionary;
+            // 标志字节为窗口大小的log2，解压时据此确定字典之后保留多少最近数据
+            uint8_t windowLog = 0;
+            while ((size_t(1) << windowLog) < m_historySize + m_dictionary.size()) windowLog++;
+            appendBlockHeader(header, kBlockDict, windowLog, m_dictionary.size(), packed.size());
+            header += packed;
+        }
+        return m_next.write(header.data(), header.size());
+    }
+
+    static void appendBlockHeader(string& out, uint8_t method, uint8_t flags, uint32_t rawSize, uint32_t packedSize) {
+        out.push_back(char(method));
+        out.push_back(char(flags));
+        putU32(out, rawSize);
+        putU32(out, packedSize);
+    }
+
+    void compressBlock(Job& job) const {
+        const char* block = job.input.data() + job.historyLen;
+        size_t size = job.input.size() - job.historyLen;
+        uint8_t flags = job.historyLen > 0 ? kFlagHistory : 0;
+        if (!m_dictionary.empty()) flags |= kFlagDict;
+
+        job.packed.clear();
+        appendBlock(m_method, flags, job.input.data(), job.historyLen, size, job.packed);
+
+        // 高熵数据上LZ77只能找到短匹配，token和偏移量比省下的字面量还贵：LZH/LZA块再试一次
+        // 只做熵编码（按kHaffBlockSize分成范式哈夫曼/rANS块，解压时照常解码），取较小者。
+        // 下限已不小于LZ结果时不必尝试
+        if ((m_method == kBlockLZH || m_method == kBlockLZA) && literalBound(block, size) < job.packed.size()) {
+            uint8_t literalMethod = m_method == kBlockLZH ? kBlockHaffCanon : kBlockANS;
+            job.literal.clear();
+            for (size_t pos = 0; pos < size; pos += kHaffBlockSize) {
+                appendBlock(literalMethod, 0, block + pos, 0, min(kHaffBlockSize, size - pos), job.literal);
+            }
+            if (job.literal.size() < job.packed.size()) job.packed.swap(job.literal);
+        }
+    }
+
+    // 压缩input中historyLen之后的size字节，追加一个数据块（块头 + 压缩数据）到out，
+    // 压缩后不比原始数据小时原样存储
+    void appendBlock(uint8_t method, uint8_t flags, const char* input, size_t historyLen, size_t size,
+                     string& out) const {
+        const char* block = input + historyLen;
+        size_t start = out.size();
+        appendBlockHeader(out, method, flags, 0, 0);
+        // 抽样判断为不可压缩的哈夫曼/rANS块不做压缩
+        bool stored = (method == kBlockHaffCanon || method == kBlockANS) && looksIncompressible(block, size);
+        if (!stored) {
+            if (method == kBlockLZSeq) {
+                LZ77Compress lz77(m_level);
+                lz77.Compress(input, historyLen, size, out);
+            } else if (method == kBlockLZH) {
+                LZHCompress::Compress(input, historyLen, size, m_level, out);
+            } else if (method == kBlockLZA) {
+                LZACompress::Compress(input, historyLen, size, m_level, out);
+            } else if (method == kBlockANS) {
+                RansCompress ransCompressor;
+                ransCompressor.Compress(block, size, out);
+            } else {
+                HuffmanComress huffCompressor;
+                huffCompressor.Compress(block, size, out);
+            }
+            stored = out.size() - start - kBlockHeaderSize >= size;
+        }
+        if (stored) {
+            out.resize(start);
+            appendBlockHeader(out, kBlockStored, 0, 0, 0);
+            out.append(block, size);
+        }
+
+        // 回填块头中的长度
+        string sizes;
+        putU32(sizes, size);
+        putU32(sizes, out.size() - start - kBlockHeaderSize);
+        out.replace(start + 2, 8, sizes);
+    }
+
+    void run() {
+        Job* job;
+        while (m_jobs.pop(job)) {
+            // 异常不能逸出工作线程，记为该块失败，由writeFront在调用线程返回false
+            try {
+                compressBlock(*job);
+                job->ok = true;
+            } catch (const exception& e) {
+                spdlog::error("压缩数据块异常：{}", e.what());
+                job->ok = false;
+            }
+            job->done.set_value();
+        }
+    }
+
+    // 提交当前块：单线程时直接压缩，否则交给线程池，在途任务达到上限时先写出最早的一块
+    bool flushBlock() {
+        unique_ptr<Job> job;
+        if (!m_free.empty()) {
+            job = std::move(m_free.back());
+            m_free.pop_back();
+        } else {
+            job = make_unique<Job>();
+        }
+        job->input.assign(m_dictionary).append(m_window);
+        job->historyLen = m_dictionary.size() + m_historyLen;
+        job->done = promise<void>();
+        job->result = job->done.get_future();
+
+        // 窗口向前滑动，只保留最近m_historySize字节
+        if (m_window.size() > m_historySize) {
+            m_window.erase(0, m_window.size() - m_historySize);
+        }
+        m_historyLen = m_window.size();
+
+        if (m_workers.empty()) {
+            compressBlock(*job);
+            job->ok = true;
+            job->done.set_value();
+            m_pending.push_back(std::move(job));
+            return writeFront();
+        }
+        m_jobs.push(job.get());
+        m_pending.push_back(std::move(job));
+        while (m_pending.size() >= m_maxInFlight ||
+               (!m_pending.empty() && m_pending.front()->result.wait_for(chrono::seconds(0)) == future_status::ready)) {
+            if (!writeFront()) return false;
         }
-        
-        in.close();
-        out.close();
-        freeHuffmanTree(root);
         return true;
     }
 
+    // 等待最早提交的块压缩完成并写入下游
+    bool writeFront() {
+        unique_ptr<Job> job = std::move(m_pending.front());
+        m_pending.pop_front();
+        job->result.wait();
+        bool ok = job->ok && writeHeader() && m_next.write(job->packed.data(), job->packed.size());
+        m_free.push_back(std::move(job));
+        return ok;
+    }
+
+    uint8_t m_method;
+    ByteSink& m_next;
+    int m_level;
+    size_t m_historySize;       // 保留给下一块引用的历史长度（不含字典），哈夫曼为0
+    size_t m_blockSize;
+    bool m_headerWritten = false;
+    string m_dictionary;        // 预置字典，随文件头写出，拼在每块的历史之前
+    string m_window;            // 历史窗口 + 待压缩的原始数据
+    size_t m_historyLen = 0;    // m_window开头的历史数据长度
+    size_t m_maxInFlight;
+    BoundedQueue<Job*> m_jobs;             // 待压缩的任务
+    deque<unique_ptr<Job>> m_pending;      // 按提交顺序排列的在途任务
+    vector<unique_ptr<Job>> m_free;        // 已写出、可复用的任务
+    vector<thread> m_workers;
 };
-// 压缩入口
-bool Compress::compress(const string& srcFile, const string& destFile, const string& alg) {
+
+// 流式解压阶段：识别分块容器或旧的整文件格式，解码后写入下游。
+// 范式哈夫曼、rANS和原样存储的块不依赖之前的数据，每个块头都是一个同步点（压缩长度即下一块的位置），
+// threadCount > 1时这些块交给线程池同时解码，按顺序写出；LZ77类的块引用之前的输出，
+// 先等在途的块全部写出再在当前线程解码
+class DecompressSink : public ByteSink {
+public:
+    DecompressSink(uint8_t legacyMethod, ByteSink& next, size_t threadCount)
+        : m_legacyMethod(legacyMethod), m_next(next), m_history(next),
+          m_threadCount(threadCount), m_maxInFlight(threadCount * 2), m_jobs(m_maxInFlight) {}
+
+    ~DecompressSink() override {
+        m_jobs.close();
+        for (auto& worker : m_workers) worker.join();
+    }
+
+    bool write(const char* data, size_t len) override {
+        if (m_failed) return false;
+        switch (m_mode) {
+        case Mode::Detect:
+            m_in.append(data, len);
+            if (m_in.size() < sizeof(kMagic)) return true;
+            detect();
+            if (m_mode == Mode::Container) return parseContainer();
+            return feedLegacy(m_in.data(), m_in.size(), true);
+        case Mode::Container:
+            m_in.append(data, len);
+            return parseContainer();
+        default:
+            return feedLegacy(data, len, false);
+        }
+    }
+
+    bool finish() override {
+        if (m_failed) return false;
+        if (m_mode == Mode::Detect) {
+            // 不足4字节，只可能是旧格式
+            detect();
+            if (!feedLegacy(m_in.data(), m_in.size(), true)) return false;
+        }
+
+        bool ok = true;
+        if (m_mode == Mode::Container) {
+            if (!drainPending()) {
+                m_failed = true;
+                return false;
+            }
+            if (!m_ended) {
+                spdlog::error("压缩数据不完整：缺少结束块");
+                ok = false;
+            }
+        } else if (m_lz77) {
+            ok = m_lz77->finish();
+        } else if (m_haff) {
+            ok = m_haff->finish();
+        }
+        return ok && m_next.finish();
+    }
+
+private:
+    enum class Mode { Detect, Container, Legacy };
+
+    void detect() {
+        if (m_in.size() >= sizeof(kMagic) && memcmp(m_in.data(), kMagic, sizeof(kMagic)) == 0) {
+            m_mode = Mode::Container;
+            return;
+        }
+        m_mode = Mode::Legacy;
+        if (m_legacyMethod == kBlockLZ77) {
+            m_lz77 = make_unique<LZ77Decoder>(m_next);
+        } else if (m_legacyMethod == kBlockHaff) {
+            m_haff = make_unique<HuffmanDecoder>(m_next);
+        }
+    }
+
+    bool feedLegacy(const char* data, size_t len, bool fromBuffer) {
+        if (!m_lz77 && !m_haff) {
+            // 旧的整文件格式只有LZ77和哈夫曼两种
+            spdlog::error("压缩数据格式无效");
+            m_failed = true;
+            return false;
+        }
+        bool ok = m_lz77 ? m_lz77->feed(data, len) : m_haff->feed(data, len);
+        if (fromBuffer) m_in.clear();
+        m_failed = !ok;
+        return ok;
+    }
+
+    bool parseContainer() {
+        size_t pos = 0;
+        bool ok = true;
+        while (ok) {
+            size_t avail = m_in.size() - pos;
+            if (!m_headerParsed) {
+                if (avail < kHeaderSize) break;
+                uint8_t version = uint8_t(m_in[pos + 4]);
+                if (version != kFormatVersion) {
+                    spdlog::error("不支持的压缩格式版本：{}", version);
+                    ok = false;
+                    break;
+                }
+                m_headerParsed = true;
+                pos += kHeaderSize;
+                continue;
+            }
+            if (m_ended) {
+                if (avail > 0) {
+                    spdlog::error("压缩数据损坏：结束块之后仍有数据");
+                    ok = false;
+                }
+                break;
+            }
+            if (avail < kBlockHeaderSize) break;
+
+            uint8_t method = uint8_t(m_in[pos]);
+            uint8_t flags = uint8_t(m_in[pos + 1]);
+            uint32_t rawSize = getU32(m_in.data() + pos + 2);
+            uint32_t packedSize = getU32(m_in.data() + pos + 6);
+            if (method == kBlockEnd) {
+                m_ended = true;
+                pos += kBlockHeaderSize;
+                continue;
+            }
+            if (rawSize > kMaxBlockBytes || packedSize > kMaxBlockBytes) {
+                spdlog::error("压缩数据损坏：块长度异常");
+                ok = false;
+                break;
+            }
+            if (avail < kBlockHeaderSize + packedSize) break;
+
+            ok = decodeBlock(method, flags, rawSize, m_in.data() + pos + kBlockHeaderSize, packedSize);
+            pos += kBlockHeaderSize + packedSize;
+        }
+        m_in.erase(0, pos);
+        m_failed = !ok;
+        return ok;
+    }
+
+    bool decodeBlock(uint8_t method, uint8_t flags, uint32_t rawSize, const char* data, uint32_t size) {
+        if (m_threadCount > 1) {
+            bool independent = method == kBlockHaffCanon || method == kBlockANS ||
+                               (method == kBlockStored && size == rawSize);
+            if (independent) return submitBlock(method, rawSize, data, size);
+            if (!drainPending()) return false;
+        }
+
+        uint64_t produced = 0;
+        switch (method) {
+        case kBlockDict: {
+            // 只能出现在所有数据块之前，标志字节为窗口大小的log2
+            size_t windowSize = flags < 32 ? size_t(1) << flags : 0;
+            if (rawSize == 0 || size > rawSize || windowSize > kLZWindow || rawSize > maxDictSize(windowSize) ||
+                !m_dictionary.empty() || !m_history.window().empty()) {
+                spdlog::error("压缩数据损坏：字典块无效");
+                return false;
+            }
+            if (size == rawSize) {
+                m_dictionary.assign(data, size);
+            } else if (!LZ77Compress::Decompress(data, size, m_dictionary, 0, rawSize)) {
+                return false;
+            }
+            m_dictHistory = windowSize - rawSize;
+            return true;
+        }
+        case kBlockStored:
+            if (size != rawSize) break;
+            if (!m_history.write(data, size)) return false;
+            m_history.trim();
+            return true;
+        case kBlockLZSeq:
+        case kBlockLZH:
+        case kBlockLZA: {
+            if (flags & kFlagDict) return decodeDictBlock(method, rawSize, data, size);
+            // 直接解码到历史窗口之后，写出新数据后窗口向前滑动
+            string& window = m_history.window();
+            size_t base = window.size();
+            size_t historyLen = (flags & kFlagHistory) ? kLZWindow : 0;
+            if (!decodeSequences(method, data, size, window, historyLen, rawSize)) return false;
+            if (!m_next.write(window.data() + base, rawSize)) return false;
+            m_history.trim();
+            return true;
+        }
+        case kBlockLZ77: {
+            LZ77Decoder decoder(m_history, rawSize);
+            if (!decoder.feed(data, size) || !decoder.finish()) return false;
+            produced = decoder.produced();
+            break;
+        }
+        case kBlockHaffCanon:
+        case kBlockANS: {
+            string& window = m_history.window();
+            size_t base = window.size();
+            bool ok = method == kBlockANS ? RansCompress::Decompress(data, size, window, rawSize)
+                                          : HuffmanComress::Decompress(data, size, window, rawSize);
+            if (!ok) return false;
+            if (!m_next.write(window.data() + base, rawSize)) return false;
+            m_history.trim();
+            return true;
+        }
+        case kBlockHaff: {
+            HuffmanDecoder decoder(m_history);
+            if (!decoder.feed(data, size) || !decoder.finish()) return false;
+            produced = decoder.produced();
+            break;
+        }
+        default:
+            spdlog::error("不支持的数据块类型：{}", method);
+            return false;
+        }
+        if (produced != rawSize) {
+            spdlog::error("压缩数据损坏：块长度不匹配");
+            return false;
+        }
+        m_history.trim();
+        return true;
+    }
+
+    // 一个独立数据块的解码任务
+    struct Job {
+        uint8_t method = kBlockStored;
+        string input;           // 压缩数据
+        uint32_t rawSize = 0;
+        string output;          // 解码结果
+        bool ok = false;
+        promise<void> done;
+        future<void> result;
+    };
+
+    // 提交一个独立块，第一次提交时才启动线程（LZ77类的数据用不到）；在途任务达到上限时先写出最早的一块
+    bool submitBlock(uint8_t method, uint32_t rawSize, const char* data, uint32_t size) {
+        if (m_workers.empty()) {
+            for (size_t i = 0; i < m_threadCount; i++) {
+                m_workers.emplace_back(&DecompressSink::run, this);
+            }
+        }
+        unique_ptr<Job> job;
+        if (!m_free.empty()) {
+            job = std::move(m_free.back());
+            m_free.pop_back();
+        } else {
+            job = make_unique<Job>();
+        }
+        job->method = method;
+        job->rawSize = rawSize;
+        job->done = promise<void>();
+        job->result = job->done.get_future();
+        if (method == kBlockStored) {
+            job->output.assign(data, size);
+            job->ok = true;
+            job->done.set_value();
+        } else {
+            job->input.assign(data, size);
+            m_jobs.push(job.get());
+        }
+        m_pending.push_back(std::move(job));
+        while (m_pending.size() >= m_maxInFlight ||
+               (!m_pending.empty() && m_pending.front()->result.wait_for(chrono::seconds(0)) == future_status::ready)) {
+            if (!writeFront()) return false;
+        }
+        return true;
+    }
+
+    void run() {
+        Job* job;
+        while (m_jobs.pop(job)) {
+            job->output.clear();
+            const char* in = job->input.data();
+            size_t inLen = job->input.size();
+            // 异常不能逸出工作线程，记为该块失败，由writeFront在调用线程返回false
+            try {
+                job->ok = job->method == kBlockANS ? RansCompress::Decompress(in, inLen, job->output, job->rawSize)
+                                                   : HuffmanComress::Decompress(in, inLen, job->output, job->rawSize);
+            } catch (const exception& e) {
+                spdlog::error("解压数据块异常：{}", e.what());
+                job->ok = false;
+            }
+            job->done.set_value();
+        }
+    }
+
+    // 等待最早提交的块解码完成并写入下游
+    bool writeFront() {
+        unique_ptr<Job> job = std::move(m_pending.front());
+        m_pending.pop_front();
+        job->result.wait();
+        bool ok = job->ok && m_history.write(job->output.data(), job->output.size());
+        m_history.trim();
+        m_free.push_back(std::move(job));
+        return ok;
+    }
+
+    bool drainPending() {
+        while (!m_pending.empty()) {
+            if (!writeFront()) return false;
+        }
+        return true;
+    }
+
+    // 按块方法解码LZ77序列，追加到window之后
+    static bool decodeSequences(uint8_t method, const char* data, uint32_t size, string& window,
+                                size_t historyLen, uint32_t rawSize) {
+        switch (method) {
+        case kBlockLZH: return LZHCompress::Decompress(data, size, window, historyLen, rawSize);
+        case kBlockLZA: return LZACompress::Decompress(data, size, window, historyLen, rawSize);
+        default:        return LZ77Compress::Decompress(data, size, window, historyLen, rawSize);
+        }
+    }
+
+    // 带kFlagDict的块：历史为字典 + 最近m_dictHistory字节的输出，拼在一起后在其后解码
+    bool decodeDictBlock(uint8_t method, uint32_t rawSize, const char* data, uint32_t size) {
+        if (m_dictionary.empty()) {
+            spdlog::error("压缩数据损坏：缺少字典块");
+            return false;
+        }
+        const string& window = m_history.window();
+        size_t recent = min(window.size(), m_dictHistory);
+        m_dictWindow.assign(m_dictionary).append(window, window.size() - recent, recent);
+        size_t base = m_dictWindow.size();
+        if (!decodeSequences(method, data, size, m_dictWindow, base, rawSize) ||
+            !m_history.write(m_dictWindow.data() + base, rawSize)) {
+            return false;
+        }
+        m_history.trim();
+        return true;
+    }
+
+    // 转发解码数据并保留最近kLZWindow字节，供之后带kFlagHistory的块引用
+    class HistorySink : public ByteSink {
+    public:
+        explicit HistorySink(ByteSink& next) : m_next(next) {}
+
+        bool write(const char* data, size_t len) override {
+            m_window.append(data, len);
+            return m_next.write(data, len);
+        }
+        bool finish() override { return m_next.finish(); }
+
+        string& window() { return m_window; }
+
+        // 每块解码完成后调用：超过两倍窗口时丢弃窗口之外的数据，均摊下来每个字节只搬移一次
+        // （引用范围由块的历史长度限制，多保留的数据不会被引用）
+        void trim() {
+            if (m_window.size() > 2 * kLZWindow) m_window.erase(0, m_window.size() - kLZWindow);
+        }
+
+    private:
+        ByteSink& m_next;
+        string m_window;
+    };
+
+    uint8_t m_legacyMethod;
+    ByteSink& m_next;
+    Mode m_mode = Mode::Detect;
+    bool m_failed = false;
+    string m_in;                          // 尚未解析的输入
+    HistorySink m_history;                // 分块格式的解码输出经过此处，保留历史窗口
+    string m_dictionary;                  // 预置字典
+    size_t m_dictHistory = 0;             // 带字典的块在字典之后保留的最近数据长度
+    string m_dictWindow;                  // 字典 + 最近数据，带字典的块在其后解码
+    bool m_headerParsed = false;
+    bool m_ended = false;
+    unique_ptr<LZ77Decoder> m_lz77;       // 旧格式解码器
+    unique_ptr<HuffmanDecoder> m_haff;
+    size_t m_threadCount;
+    size_t m_maxInFlight;
+    BoundedQueue<Job*> m_jobs;             // 待解码的任务
+    deque<unique_ptr<Job>> m_pending;      // 按块顺序排列的在途任务
+    vector<unique_ptr<Job>> m_free;        // 已写出、可复用的任务
+    vector<thread> m_workers;
+};
+
+
+// 算法名 -> 块压缩方法
+static bool methodForAlg(const string& alg, uint8_t& method) {
     if (alg == "LZ77") {
-        LZ77Compress lz77;
-        return lz77.Compress(srcFile, destFile);
+        method = kBlockLZ77;
     } else if (alg == "Haff") {
-        HuffmanComress huffCompressor;
-        return huffCompressor.Compress(srcFile, destFile);
+        method = kBlockHaff;
+    } else if (alg == "LZH") {
+        method = kBlockLZH;
+    } else if (alg == "ANS") {
+        method = kBlockANS;
+    } else if (alg == "LZA") {
+        method = kBlockLZA;
     } else {
+        spdlog::error("不支持的压缩算法：{}", alg);
         return false;
     }
+    return true;
+}
+
+unique_ptr<ByteSink> Compress::createCompressor(const string& alg, ByteSink& next, int level, size_t threadCount,
+                                               const string& dictionary) {
+    uint8_t method;
+    if (!methodForAlg(alg, method)) return nullptr;
+    if (level < kMinLevel || level > kMaxLevel) {
+        spdlog::error("不支持的压缩级别：{}（{}-{}）", level, kMinLevel, kMaxLevel);
+        return nullptr;
+    }
+    // 写入序列格式和范式哈夫曼，旧格式只用于解码
+    if (method == kBlockLZ77) method = kBlockLZSeq;
+    if (method == kBlockHaff) method = kBlockHaffCanon;
+    if (threadCount == 0) threadCount = max(thread::hardware_concurrency(), 1u);
+    return make_unique<CompressSink>(method, next, level, threadCount, dictionary);
+}
+
+string Compress::trainDictionary(const vector<string>& samples, size_t maxSize) {
+    const size_t kGram = 8;          // 按8字节子串统计出现在多少个样本中
+    const size_t kSegment = 64;      // 字典由64字节的片段组成
+    const size_t kStep = 16;         // 候选片段的起点间隔
+    const int kHashBits = 20;        // 子串计数表大小，哈希冲突只影响评分精度
+
+    auto hashGram = [](const char* p) {
+        uint64_t v;
+        memcpy(&v, p, sizeof(v));
+        return uint32_t((v * 0x9E3779B97F4A7C15ull) >> (64 - kHashBits));
+    };
+
+    // 每个子串出现在多少个样本中（同一样本只计一次）
+    vector<uint16_t> docFreq(size_t(1) << kHashBits, 0);
+    vector<uint32_t> lastDoc(size_t(1) << kHashBits, UINT32_MAX);
+    for (uint32_t i = 0; i < samples.size(); i++) {
+        const string& s = samples[i];
+        for (size_t p = 0; p + kGram <= s.size(); p++) {
+            uint32_t h = hashGram(s.data() + p);
+            if (lastDoc[h] == i) continue;
+            lastDoc[h] = i;
+            if (docFreq[h] < UINT16_MAX) docFreq[h]++;
+        }
+    }
+
+    // 片段得分：其中在至少两个样本中出现的子串数之和，已选入字典的子串不再计分
+    auto score = [&](const string& s, size_t pos) {
+        uint64_t total = 0;
+        for (size_t p = pos; p + kGram <= pos + kSegment; p++) {
+            uint16_t f = docFreq[hashGram(s.data() + p)];
+            if (f >= 2) total += f - 1;
+        }
+        return total;
+    };
+
+    struct Candidate {
+        uint64_t score;
+        uint32_t sample;
+        uint32_t pos;
+        bool operator<(const Candidate& o) const { return score < o.score; }
+    };
+    priority_queue<Candidate> candidates;
+    for (uint32_t i = 0; i < samples.size(); i++) {
+        for (size_t pos = 0; pos + kSegment <= samples[i].size(); pos += kStep) {
+            uint64_t sc = score(samples[i], pos);
+            if (sc > 0) candidates.push({sc, i, uint32_t(pos)});
+        }
+    }
+
+    // 贪心选取：取出得分最高的片段后重新计分，仍不低于其余候选时选入
+    vector<const char*> chosen;
+    while (!candidates.empty() && (chosen.size() + 1) * kSegment <= maxSize) {
+        Candidate c = candidates.top();
+        candidates.pop();
+        const string& s = samples[c.sample];
+        c.score = score(s, c.pos);
+        if (c.score == 0) continue;
+        if (!candidates.empty() && c.score < candidates.top().score) {
+            candidates.push(c);
+            continue;
+        }
+        chosen.push_back(s.data() + c.pos);
+        for (size_t p = c.pos; p + kGram <= c.pos + kSegment; p++) docFreq[hashGram(s.data() + p)] = 0;
+    }
+
+    string dictionary;
+    dictionary.reserve(chosen.size() * kSegment);
+    for (auto it = chosen.rbegin(); it != chosen.rend(); ++it) dictionary.append(*it, kSegment);
+    return dictionary;
+}
+
+unique_ptr<ByteSink> Compress::createDecompressor(const string& alg, ByteSink& next, size_t threadCount) {
+    uint8_t method;
+    if (!methodForAlg(alg, method)) return nullptr;
+    if (threadCount == 0) threadCount = max(thread::hardware_concurrency(), 1u);
+    return make_unique<DecompressSink>(method, next, threadCount);
+}
+
+// 压缩入口
+bool Compress::compress(const string& srcFile, const string& destFile, const string& alg) {
+    FileByteSink out(destFile);
+    if (!out.isOpen()) return false;
+    auto compressor = createCompressor(alg, out);
+    return compressor && pumpFile(srcFile, *compressor);
 }
 
 // 解压入口
 bool Compress::decompress(const string& compressFile, const string& destFile, const string& alg) {
-    if (alg == "LZ77") {
-        LZ77Compress lz77;
-        return lz77.Decompress(compressFile, destFile);
-    } else if (alg == "Haff") {
-        HuffmanComress huffCompressor;
-        return huffCompressor.Decompress(compressFile, destFile);
-    } else {
-        return false;
-    }
-}
\ No newline at end of file
+    FileByteSink out(destFile);
+    if (!out.isOpen()) return false;
+    auto decompressor = createDecompressor(alg, out);
+    return decompressor && pumpFile(compressFile, *decompressor);
+}
@@ -1,11 +1,36 @@
 #pragma once
 #include <string>
+#include <memory>
+#include <vector>
+#include "Stream.h"
 
 class Compress {
 public:
-    // 压缩：srcFile-源文件，destFile-压缩文件，alg-算法（LZ77/Haff）
+    // 压缩级别：1最快，9压缩率最高，只影响LZ77/LZH/LZA的匹配查找
+    static constexpr int kMinLevel = 1;
+    static constexpr int kMaxLevel = 9;
+    static constexpr int kDefaultLevel = 6;
+    static constexpr size_t kDefaultDictSize = 64 << 10;
+
+    // 压缩：srcFile-源文件，destFile-压缩文件，alg-算法（LZ77/Haff/LZH/ANS/LZA）
     static bool compress(const std::string& srcFile, const std::string& destFile, const std::string& alg);
 
-    // 解压：compressFile-压缩文件，destFile-解压文件，alg-算法（LZ77/Haff）
+    // 解压：compressFile-压缩文件，destFile-解压文件，alg-算法（LZ77/Haff/LZH/ANS/LZA）
     static bool decompress(const std::string& compressFile, const std::string& destFile, const std::string& alg);
-};
\ No newline at end of file
+
+    // 流式压缩阶段：按块压缩后写入next，算法或级别不支持时返回nullptr。
+    // threadCount为同时压缩的线程数，0表示CPU核数，1表示在调用线程中压缩；
+    // dictionary非空时固定在LZ77/LZH/LZA每块的历史窗口之前，并随压缩数据保存一份
+    static std::unique_ptr<ByteSink> createCompressor(const std::string& alg, ByteSink& next,
+                                                      int level = kDefaultLevel, size_t threadCount = 0,
+                                                      const std::string& dictionary = std::string());
+
+    // 从样本（如若干文件的开头部分）中训练字典：挑出在多个样本中重复出现的片段，
+    // 最常用的放在末尾，离待压缩数据最近
+    static std::string trainDictionary(const std::vector<std::string>& samples, size_t maxSize = kDefaultDictSize);
+
+    // 流式解压阶段：自动识别分块格式，旧格式按alg解码。
+    // 哈夫曼/rANS的数据块用threadCount个线程同时解码，0表示CPU核数，1表示在调用线程中解码
+    static std::unique_ptr<ByteSink> createDecompressor(const std::string& alg, ByteSink& next,
+                                                        size_t threadCount = 0);
+};
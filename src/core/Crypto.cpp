@@ -2,147 +2,122 @@
 #include "Crypto.h"
 #include <fstream>
 #include <iostream>
+#include <cstring>
 #include <crypto++/aes.h>
 #include <crypto++/des.h>
 #include <crypto++/modes.h>
 #include <crypto++/filters.h>
 #include <crypto++/hex.h>
-#include <crypto++/files.h> // 必须包含，提供FileSource/FileSink支持
 #include "spdlog/spdlog.h"
 using namespace std;
 using namespace CryptoPP;
 
-// AES加密（ECB模式，修复类型转换+流操作）
-bool aesEncrypt(const string& srcFile, const string& destFile, const string& password) {
-    try {
-        // 密码填充到16字节（AES-128密钥长度）
-        string key(16, 0);
-        memcpy(&key[0], password.c_str(), min(password.size(), (size_t)16));
-
-        // 显式类型转换：char* -> const unsigned char*（const unsigned char*）
-        const unsigned char* aesKey = reinterpret_cast<const unsigned char*>(key.data());
-        AES::Encryption aesEnc(aesKey, AES::DEFAULT_KEYLENGTH);
-        ECB_Mode_ExternalCipher::Encryption ecbEnc(aesEnc);
-
-        // CryptoPP原生文件流处理，无需C++标准fstream
-        FileSource(
-            srcFile.c_str(),  // 源文件路径
-            true,             // 处理完成后自动关闭文件
-            new StreamTransformationFilter( // 加密过滤器链
-                ecbEnc,
-                new FileSink(destFile.c_str()) // 加密后写入目标文件
-            )
-        );
-
-        return true;
-    } catch (const Exception& e) {
-        spdlog::error("AES加密异常：{}", e.what());
-        return false;
+// 把Crypto++过滤器的输出转发给流水线下游阶段
+class ByteSinkAdapter : public Bufferless<Sink> {
+public:
+    explicit ByteSinkAdapter(ByteSink& next) : m_next(next) {}
+
+    size_t Put2(const CryptoPP::byte* inString, size_t length, int messageEnd, bool blocking) override {
+        CRYPTOPP_UNUSED(messageEnd);
+        CRYPTOPP_UNUSED(blocking);
+        if (length > 0 && !m_next.write(reinterpret_cast<const char*>(inString), length)) {
+            throw Exception(Exception::IO_ERROR, "写入下游失败");
+        }
+        return 0;
     }
-}
-
-// AES解密（修复类型转换+流操作）
-bool aesDecrypt(const string& encryptFile, const string& destFile, const string& password) {
-    try {
-        string key(16, 0);
-        memcpy(&key[0], password.c_str(), min(password.size(), (size_t)16));
-
-        // 显式类型转换：char* -> const unsigned char*
-        const unsigned char* aesKey = reinterpret_cast<const unsigned char*>(key.data());
-        AES::Decryption aesDec(aesKey, AES::DEFAULT_KEYLENGTH);
-        ECB_Mode_ExternalCipher::Decryption ecbDec(aesDec);
 
-        FileSource(
-            encryptFile.c_str(),
-            true,
-            new StreamTransformationFilter(
-                ecbDec,
-                new FileSink(destFile.c_str())
-            )
-        );
-
-        return true;
-    } catch (const Exception& e) {
-        spdlog::error("AES解密异常：{}", e.what());
-        return false;
+private:
+    ByteSink& m_next;
+};
+
+// 分组密码流式阶段（ECB模式，PKCS填充）
+// Cipher: AES/DES的Encryption或Decryption，Mode: 对应的ECB模式
+template <class Cipher, class Mode>
+class CipherSink : public ByteSink {
+public:
+    CipherSink(const string& password, size_t keyLength, const string& errorPrefix, ByteSink& next)
+        : m_next(next),
+          m_errorPrefix(errorPrefix),
+          m_key(makeKey(password, keyLength)),
+          // 显式类型转换：char* -> const unsigned char*
+          m_cipher(reinterpret_cast<const unsigned char*>(m_key.data()), keyLength),
+          m_mode(m_cipher),
+          m_filter(m_mode, new ByteSinkAdapter(next)) {}
+
+    bool write(const char* data, size_t len) override {
+        try {
+            m_filter.Put(reinterpret_cast<const unsigned char*>(data), len);
+            return true;
+        } catch (const Exception& e) {
+            spdlog::error("{}：{}", m_errorPrefix, e.what());
+            return false;
+        }
     }
-}
-
-// DES加密
-bool desEncrypt(const string& srcFile, const string& destFile, const string& password) {
-    try {
-        // 密码填充到8字节（DES密钥长度）
-        string key(8, 0);
-        memcpy(&key[0], password.c_str(), min(password.size(), (size_t)8));
 
-        // 显式类型转换：char* -> const unsigned char*
-        const unsigned char* desKey = reinterpret_cast<const unsigned char*>(key.data());
-        DES::Encryption desEnc(desKey, DES::DEFAULT_KEYLENGTH);
-        ECB_Mode_ExternalCipher::Encryption ecbEnc(desEnc);
-
-        FileSource(
-            srcFile.c_str(),
-            true,
-            new StreamTransformationFilter(
-                ecbEnc,
-                new FileSink(destFile.c_str())
-            )
-        );
-
-        return true;
-    } catch (const Exception& e) {
-        spdlog::error("DES加密异常：{}", e.what());
-        return false;
+    bool finish() override {
+        try {
+            m_filter.MessageEnd();
+        } catch (const Exception& e) {
+            spdlog::error("{}：{}", m_errorPrefix, e.what());
+            return false;
+        }
+        return m_next.finish();
     }
-}
 
-// DES解密（修复类型转换，解决核心编译错误）
-bool desDecrypt(const string& encryptFile, const string& destFile, const string& password) {
-    try {
-        string key(8, 0);
-        memcpy(&key[0], password.c_str(), min(password.size(), (size_t)8));
+private:
+    // 密码填充到密钥长度（AES-128为16字节，DES为8字节）
+    static string makeKey(const string& password, size_t keyLength) {
+        string key(keyLength, 0);
+        memcpy(&key[0], password.c_str(), min(password.size(), keyLength));
+        return key;
+    }
 
-        // 显式类型转换：char* -> const unsigned char*（关键修复点）
-        const unsigned char* desKey = reinterpret_cast<const unsigned char*>(key.data());
-        DES::Decryption desDec(desKey, DES::DEFAULT_KEYLENGTH); // 现在类型匹配
-        ECB_Mode_ExternalCipher::Decryption ecbDec(desDec);
+    ByteSink& m_next;
+    string m_errorPrefix;
+    string m_key;
+    Cipher m_cipher;
+    Mode m_mode;
+    StreamTransformationFilter m_filter;
+};
 
-        FileSource(
-            encryptFile.c_str(),
-            true,
-            new StreamTransformationFilter(
-                ecbDec,
-                new FileSink(destFile.c_str())
-            )
-        );
+// 加密入口
+bool Crypto::encrypt(const string& srcFile, const string& destFile, const string& alg, const string& password) {
+    FileByteSink out(destFile);
+    if (!out.isOpen()) return false;
+    auto encryptor = createEncryptor(alg, password, out);
+    return encryptor && pumpFile(srcFile, *encryptor);
+}
 
-        return true;
-    } catch (const Exception& e) {
-        spdlog::error("DES解密异常：{}", e.what());
-        return false;
-    }
+// 解密入口
+bool Crypto::decrypt(const string& encryptFile, const string& destFile, const string& alg, const string& password) {
+    FileByteSink out(destFile);
+    if (!out.isOpen()) return false;
+    auto decryptor = createDecryptor(alg, password, out);
+    return decryptor && pumpFile(encryptFile, *decryptor);
 }
 
-// 加密入口
-bool Crypto::encrypt(const string& srcFile, const string& destFile, const string& alg, const string& password) {
+unique_ptr<ByteSink> Crypto::createEncryptor(const string& alg, const string& password, ByteSink& next) {
     if (alg == "AES") {
-        return aesEncrypt(srcFile, destFile, password);
+        return make_unique<CipherSink<AES::Encryption, ECB_Mode_ExternalCipher::Encryption>>(
+            password, AES::DEFAULT_KEYLENGTH, "AES加密异常", next);
     } else if (alg == "DES") {
-        return desEncrypt(srcFile, destFile, password);
+        return make_unique<CipherSink<DES::Encryption, ECB_Mode_ExternalCipher::Encryption>>(
+            password, DES::DEFAULT_KEYLENGTH, "DES加密异常", next);
     } else {
         spdlog::error("不支持的加密算法：{}", alg);
-        return false;
+        return nullptr;
     }
 }
 
-// 解密入口
-bool Crypto::decrypt(const string& encryptFile, const string& destFile, const string& alg, const string& password) {
+unique_ptr<ByteSink> Crypto::createDecryptor(const string& alg, const string& password, ByteSink& next) {
     if (alg == "AES") {
-        return aesDecrypt(encryptFile, destFile, password);
+        return make_unique<CipherSink<AES::Decryption, ECB_Mode_ExternalCipher::Decryption>>(
+            password, AES::DEFAULT_KEYLENGTH, "AES解密异常", next);
     } else if (alg == "DES") {
-        return desDecrypt(encryptFile, destFile, password);
+        return make_unique<CipherSink<DES::Decryption, ECB_Mode_ExternalCipher::Decryption>>(
+            password, DES::DEFAULT_KEYLENGTH, "DES解密异常", next);
     } else {
         spdlog::error("不支持的解密算法：{}", alg);
-        return false;
+        return nullptr;
     }
-}
\ No newline at end of file
+}
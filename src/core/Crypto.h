@@ -1,13 +1,21 @@
 #pragma once
 #include <string>
+#include <memory>
+#include "Stream.h"
 
 class Crypto {
 public:
     // 加密：srcFile-源文件，destFile-加密文件，alg-算法（AES/DES），password-密码
-    static bool encrypt(const std::string& srcFile, const std::string& destFile, 
+    static bool encrypt(const std::string& srcFile, const std::string& destFile,
                         const std::string& alg, const std::string& password);
 
     // 解密：encryptFile-加密文件，destFile-解密文件，alg-算法（AES/DES），password-密码
-    static bool decrypt(const std::string& encryptFile, const std::string& destFile, 
+    static bool decrypt(const std::string& encryptFile, const std::string& destFile,
                         const std::string& alg, const std::string& password);
+
+    // 流式加密阶段：密文写入next，算法不支持时返回nullptr
+    static std::unique_ptr<ByteSink> createEncryptor(const std::string& alg, const std::string& password, ByteSink& next);
+
+    // 流式解密阶段：明文写入next，算法不支持时返回nullptr
+    static std::unique_ptr<ByteSink> createDecryptor(const std::string& alg, const std::string& password, ByteSink& next);
 };
@@ -0,0 +1,176 @@
+#include "DirWalker.h"
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <dirent.h>
+#include <cerrno>
+#include <cstring>
+#include "spdlog/spdlog.h"
+
+using namespace std;
+
+namespace {
+
+const size_t kDirBufferSize = 64 * 1024;   // 每次getdents64读取的缓冲大小
+const size_t kMaxWalkThreads = 16;
+
+// getdents64返回的记录头：d_ino(8) d_off(8) d_reclen(2) d_type(1)，之后是以'\0'结尾的名称
+const size_t kDirentReclenOffset = 16;
+const size_t kDirentTypeOffset = 18;
+const size_t kDirentNameOffset = 19;
+
+size_t defaultThreadCount() {
+    size_t n = thread::hardware_concurrency();
+    return min(max<size_t>(n, 2), kMaxWalkThreads);
+}
+
+} // namespace
+
+DirWalker::DirWalker(const FilterRule& rule, size_t threadCount)
+    : m_rule(rule),
+      m_threadCount(threadCount > 0 ? threadCount : defaultThreadCount()),
+      m_queues(m_threadCount) {
+    m_rule.compile();
+}
+
+bool DirWalker::walk(const fs::path& root, const Callback& onMatch) {
+    m_onMatch = &onMatch;
+    m_stop = false;
+
+    // 根目录本身被排除时无需遍历
+    PathTrie::State rootState;
+    if (!m_rule.pathTrie()->start(fs::absolute(root), rootState)) {
+        spdlog::info("遍历根目录在排除路径中：{}", root.string());
+        return true;
+    }
+    pushTask(0, DirTask{root, "", std::move(rootState)});
+
+    vector<thread> workers;
+    for (size_t i = 0; i < m_threadCount; i++) {
+        workers.emplace_back(&DirWalker::workerLoop, this, i);
+    }
+    for (auto& t : workers) t.join();
+
+    m_onMatch = nullptr;
+    return !m_stop;
+}
+
+void DirWalker::pushTask(size_t self, DirTask task) {
+    m_pending++;
+    {
+        lock_guard<mutex> lock(m_queues[self].mutex);
+        m_queues[self].tasks.push_back(std::move(task));
+    }
+    m_available++;
+    lock_guard<mutex> lock(m_idleMutex);
+    m_idleCv.notify_one();
+}
+
+bool DirWalker::takeTask(size_t self, DirTask& task) {
+    // 先取自己队列尾部的任务
+    {
+        WorkQueue& own = m_queues[self];
+        lock_guard<mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            m_available--;
+            return true;
+        }
+    }
+    // 再从其他线程队列头部窃取（靠近根的目录，子树通常更大）
+    for (size_t i = 1; i < m_threadCount; i++) {
+        WorkQueue& victim = m_queues[(self + i) % m_threadCount];
+        lock_guard<mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            m_available--;
+            return true;
+        }
+    }
+    return false;
+}
+
+void DirWalker::workerLoop(size_t self) {
+    vector<char> buf(kDirBufferSize);
+    DirTask task;
+    while (true) {
+        if (takeTask(self, task)) {
+            if (!m_stop) scanDir(self, task, buf);
+            // 子目录已全部入队后才减少计数，计数归零即遍历完成
+            if (--m_pending == 0) {
+                lock_guard<mutex> lock(m_idleMutex);
+                m_idleCv.notify_all();
+            }
+            continue;
+        }
+
+        unique_lock<mutex> lock(m_idleMutex);
+        m_idleCv.wait(lock, [this] { return m_pending == 0 || m_available > 0; });
+        if (m_pending == 0) break;
+    }
+}
+
+void DirWalker::scanDir(size_t self, const DirTask& task, vector<char>& buf) {
+    // 根目录允许是符号链接，子目录不跟随符号链接
+    int flags = O_RDONLY | O_DIRECTORY | O_CLOEXEC;
+    if (!task.relPath.empty()) flags |= O_NOFOLLOW;
+    int fd = open(task.path.c_str(), flags);
+    if (fd < 0) {
+        spdlog::warn("无法打开目录：{}，{}", task.path.string(), strerror(errno));
+        return;
+    }
+
+    const PathTrie& trie = *m_rule.pathTrie();
+    PathTrie::State childState;
+    while (!m_stop) {
+        long n = syscall(SYS_getdents64, fd, buf.data(), buf.size());
+        if (n < 0) {
+            spdlog::warn("读取目录失败：{}，{}", task.path.string(), strerror(errno));
+            break;
+        }
+        if (n == 0) break;
+
+        for (long off = 0; off < n && !m_stop;) {
+            const char* rec = buf.data() + off;
+            unsigned short reclen;
+            memcpy(&reclen, rec + kDirentReclenOffset, sizeof(reclen));
+            off += reclen;
+
+            unsigned char type = uint8_t(rec[kDirentTypeOffset]);
+            const char* name = rec + kDirentNameOffset;
+            if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0) continue;
+
+            // 排除路径在打开目录之前检查，被排除的目录整棵子树都不访问
+            string childName(name);
+            if (!trie.step(task.excludeState, childName, childState)) continue;
+
+            fs::path childPath = task.path / childName;
+            string childRel = task.relPath.empty() ? childName : task.relPath + "/" + childName;
+
+            // 应用其余筛选规则（类型、大小、时间等）。d_type已能排除的条目不再读取元数据，
+            // 其余条目相对已打开的目录fd做一次statx
+            bool matched = false;
+            FileMeta meta;
+            if (type == DT_UNKNOWN || m_rule.matchType(DTTOIF(type))) {
+                if (FileMeta::load(fd, name, meta)) {
+                    if (S_ISDIR(meta.mode)) type = DT_DIR;
+                    matched = m_rule.matchEntry(childName, meta);
+                } else {
+                    spdlog::warn("跳过无法读取的文件：{}，{}", childPath.string(), strerror(errno));
+                }
+            }
+            if (matched && !(*m_onMatch)(childPath, childRel, meta)) {
+                m_stop = true;
+                break;
+            }
+            if (type == DT_DIR) {
+                pushTask(self, DirTask{std::move(childPath), std::move(childRel), std::move(childState)});
+            }
+        }
+    }
+    close(fd);
+}
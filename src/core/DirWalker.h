@@ -0,0 +1,58 @@
+// DirWalker.h
+#pragma once
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <filesystem>
+#include "Filter.h"
+
+namespace fs = std::filesystem;
+
+// 多线程递归目录遍历：每个工作线程维护自己的目录队列，空闲时从其他线程窃取任务。
+// 目录通过getdents64整块读取，符合筛选规则的条目边遍历边交给回调，不预先构建完整列表
+class DirWalker {
+public:
+    // path为实际路径，relPath为相对遍历根目录的路径，meta为筛选时读取的元数据（不跟随符号链接）；
+    // 在工作线程中调用，返回false终止遍历
+    using Callback = std::function<bool(const fs::path& path, const std::string& relPath, const FileMeta& meta)>;
+
+    // rule在构造时复制并编译；threadCount为0时按CPU核数决定
+    explicit DirWalker(const FilterRule& rule, size_t threadCount = 0);
+
+    // 遍历root下的整棵目录树（不含root本身），遍历完成或被回调终止后返回
+    bool walk(const fs::path& root, const Callback& onMatch);
+
+private:
+    // 待遍历的目录
+    struct DirTask {
+        fs::path path;
+        std::string relPath;
+        PathTrie::State excludeState;   // 排除路径前缀树的匹配进度
+    };
+
+    // 每个工作线程的任务队列：自己从尾部取（深度优先），窃取者从头部取
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<DirTask> tasks;
+    };
+
+    void workerLoop(size_t self);
+    bool takeTask(size_t self, DirTask& task);
+    void pushTask(size_t self, DirTask task);
+    void scanDir(size_t self, const DirTask& task, std::vector<char>& buf);
+
+    FilterRule m_rule;                    // 编译后的规则副本，所有工作线程共享
+    size_t m_threadCount;
+    const Callback* m_onMatch = nullptr;
+
+    std::vector<WorkQueue> m_queues;
+    std::atomic<size_t> m_pending{0};     // 已入队但尚未遍历完成的目录数
+    std::atomic<size_t> m_available{0};   // 队列中可取的目录数
+    std::atomic<bool> m_stop{false};
+    std::mutex m_idleMutex;
+    std::condition_variable m_idleCv;
+};
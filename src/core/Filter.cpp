@@ -1,96 +1,146 @@
 #include "Filter.h"
 #include <sys/stat.h>
-#include <pwd.h>
-#include <grp.h>
+#include "OwnerCache.h"
+#include "spdlog/spdlog.h"
+#include <fcntl.h>
+#include <cerrno>
 
-bool FilterRule::match(const fs::path &filePath) const
+bool FileMeta::load(int dirFd, const char *name, FileMeta &meta)
+{
+#ifdef __linux__
+    struct statx stx;
+    unsigned int mask = STATX_TYPE | STATX_MODE | STATX_SIZE | STATX_UID | STATX_GID | STATX_MTIME | STATX_BTIME;
+    if (statx(dirFd, name, AT_SYMLINK_NOFOLLOW, mask, &stx) != 0)
+        return false;
+    meta.mode = stx.stx_mode;
+    meta.size = stx.stx_size;
+    meta.uid = stx.stx_uid;
+    meta.gid = stx.stx_gid;
+    meta.modifyTime = stx.stx_mtime.tv_sec;
+    // 部分文件系统（如较老的NFS）不提供创建时间，用修改时间代替
+    meta.createTime = (stx.stx_mask & STATX_BTIME) ? stx.stx_btime.tv_sec : meta.modifyTime;
+#else
+    struct stat st;
+    if (fstatat(dirFd, name, &st, AT_SYMLINK_NOFOLLOW) != 0)
+        return false;
+    meta.mode = st.st_mode;
+    meta.size = st.st_size;
+    meta.uid = st.st_uid;
+    meta.gid = st.st_gid;
+    meta.modifyTime = st.st_mtime;
+    meta.createTime = st.st_mtime;
+#endif
+    return true;
+}
+
+void FilterRule::compile()
 {
-    fs::file_status status = fs::status(filePath);
+    m_nameMatcher = std::make_shared<NameMatcher>(excludeNames);
+    m_pathTrie = std::make_shared<PathTrie>(excludePaths);
+    m_owners = resolveOwners();
+}
 
-    // 1. 匹配文件类型
-    bool typeMatch = false;
+std::shared_ptr<const FilterRule::OwnerSets> FilterRule::resolveOwners() const
+{
+    auto owners = std::make_shared<OwnerSets>();
+    for (const auto &u : excludeUsers)
+    {
+        uid_t uid;
+        if (OwnerCache::userId(u, uid))
+            owners->uids.insert(uid);
+        else
+            spdlog::warn("未知用户，忽略该排除规则：{}", u);
+    }
+    for (const auto &g : excludeGroups)
+    {
+        gid_t gid;
+        if (OwnerCache::groupId(g, gid))
+            owners->gids.insert(gid);
+        else
+            spdlog::warn("未知用户组，忽略该排除规则：{}", g);
+    }
+    return owners;
+}
+
+bool FilterRule::matchType(mode_t mode) const
+{
     for (const auto &type : includeTypes)
     {
         if (type == "all")
-        {
-            typeMatch = true;
-            break;
-        }
-        if (type == "-" && fs::is_regular_file(status))
-            typeMatch = true;
-        if (type == "d" && fs::is_directory(status))
-            typeMatch = true;
-        if (type == "l" && fs::is_symlink(status))
-            typeMatch = true;
+            return true;
+        if (type == "-" && S_ISREG(mode))
+            return true;
+        if (type == "d" && S_ISDIR(mode))
+            return true;
+        if (type == "l" && S_ISLNK(mode))
+            return true;
         // 支持管道、设备文件等（扩展）
     }
-    if (!typeMatch)
-        return false;
+    return false;
+}
 
-    // 2. 匹配文件大小 (仅普通文件)
-    if (fs::is_regular_file(status))
+bool FilterRule::match(const fs::path &filePath) const
+{
+    FileMeta meta;
+    if (!FileMeta::load(AT_FDCWD, filePath.c_str(), meta))
+        throw fs::filesystem_error("无法读取文件信息", filePath, std::error_code(errno, std::generic_category()));
+    return match(filePath, meta);
+}
+
+bool FilterRule::match(const fs::path &filePath, const FileMeta &meta) const
+{
+    // 排除规则：路径（未编译的规则临时建一棵前缀树）
+    if (!excludePaths.empty())
     {
-        uint64_t fileSize = fs::file_size(filePath);
-        if (fileSize < minSize || fileSize > maxSize)
+        std::shared_ptr<const PathTrie> paths = m_pathTrie;
+        if (!paths)
+            paths = std::make_shared<PathTrie>(excludePaths);
+        if (paths->excluded(filePath))
             return false;
     }
+    return matchEntry(filePath.filename().string(), meta);
+}
 
-    // 3. 匹配时间（创建/修改）
-    // 获取文件时间
-    auto createTime = fs::last_write_time(filePath); // 用写入时间代替创建时间
-    auto modifyTime = fs::last_write_time(filePath); // 最后修改时间
+bool FilterRule::matchEntry(const std::string &name, const FileMeta &meta) const
+{
+    // 1. 匹配文件类型
+    if (!matchType(meta.mode))
+        return false;
 
-    // 将 file_time_type 转换为 time_t
-    auto toTimeT = [](const fs::file_time_type &ftime) -> time_t
+    // 2. 匹配文件大小 (仅普通文件)
+    if (S_ISREG(meta.mode))
     {
-        // 方法1: 使用 system_clock 转换
-        auto sctp = std::chrono::time_point_cast<std::chrono::system_clock::duration>(
-            ftime - fs::file_time_type::clock::now() + std::chrono::system_clock::now());
-        return std::chrono::system_clock::to_time_t(sctp);
-    };
-
-    time_t createTimeT = toTimeT(createTime);
-    time_t modifyTimeT = toTimeT(modifyTime);
+        if (meta.size < minSize || meta.size > maxSize)
+            return false;
+    }
 
-    // 检查时间范围
-    if (createTimeT < minCreateTime || createTimeT > maxCreateTime)
+    // 3. 匹配时间（创建/修改）
+    if (meta.createTime < minCreateTime || meta.createTime > maxCreateTime)
         return false;
 
-    if (modifyTimeT < minModifyTime || modifyTimeT > maxModifyTime)
+    if (meta.modifyTime < minModifyTime || meta.modifyTime > maxModifyTime)
         return false;
 
-    // 4. 排除规则：路径
-    for (const auto &path : excludePaths)
+    // 4. 排除规则：用户/用户组（按数字ID比较，不再逐个文件查询名称）
+    if (!excludeUsers.empty() || !excludeGroups.empty())
     {
-        if (filePath.string().find(path) != std::string::npos)
+        std::shared_ptr<const OwnerSets> owners = m_owners;
+        if (!owners)
+            owners = resolveOwners();
+        if (owners->uids.count(meta.uid) || owners->gids.count(meta.gid))
             return false;
     }
 
-    // 5. 排除规则：用户/用户组（Linux仅支持）
-#ifdef __linux__
-    struct stat st;
-    stat(filePath.c_str(), &st);
-    std::string user = getpwuid(st.st_uid)->pw_name;
-    std::string group = getgrgid(st.st_gid)->gr_name;
-    for (const auto &u : excludeUsers)
-    {
-        if (user == u)
-            return false;
-    }
-    for (const auto &g : excludeGroups)
-    {
-        if (group == g)
-            return false;
-    }
-#endif
-
-    // 6. 排除规则：文件名（正则）
-    for (const auto &name : excludeNames)
+    // 5. 排除规则：文件名（通配符/正则）
+    if (!excludeNames.empty())
     {
-        std::regex reg(name);
-        if (regex_match(filePath.filename().string(), reg))
+        // 未编译的规则临时编译一份（较慢，遍历时应先调用compile）
+        std::shared_ptr<const NameMatcher> names = m_nameMatcher;
+        if (!names)
+            names = std::make_shared<NameMatcher>(excludeNames);
+        if (names->match(name))
             return false;
     }
 
     return true;
-}
\ No newline at end of file
+}
@@ -1,10 +1,28 @@
 #pragma once
 #include <string>
 #include <filesystem>
-#include <regex>
+#include <vector>
+#include <memory>
+#include <unordered_set>
+#include <sys/types.h>
+#include "NameMatcher.h"
+#include "PathTrie.h"
 
 namespace fs = std::filesystem;
 
+// 筛选所需的文件元数据，由一次statx调用填充（不跟随符号链接）
+struct FileMeta {
+    mode_t mode = 0;          // 文件类型与权限
+    uint64_t size = 0;        // 文件大小（字节）
+    uid_t uid = 0;
+    gid_t gid = 0;
+    time_t createTime = 0;    // 创建时间（文件系统不支持时为修改时间）
+    time_t modifyTime = 0;    // 最后修改时间
+
+    // 读取dirFd目录下name的元数据，dirFd为AT_FDCWD时name按普通路径解析
+    static bool load(int dirFd, const char* name, FileMeta& meta);
+};
+
 struct FilterRule {
     // 包含规则
     std::vector<std::string> includeTypes{"-","l","d"};  // 文件类型（普通文件/目录/链接等）
@@ -16,11 +34,36 @@ struct FilterRule {
     time_t maxModifyTime = INT64_MAX;// 最大修改时间
 
     // 排除规则
-    std::vector<std::string> excludePaths;  // 排除目录
-    std::vector<std::string> excludeUsers;  // 排除用户
-    std::vector<std::string> excludeGroups; // 排除用户组
-    std::vector<std::string> excludeNames;  // 排除文件名（支持正则）
+    std::vector<std::string> excludePaths;  // 排除目录（'/'开头从根匹配，否则匹配任意位置的目录名）
+    std::vector<std::string> excludeUsers;  // 排除用户（用户名或数字uid）
+    std::vector<std::string> excludeGroups; // 排除用户组（组名或数字gid）
+    std::vector<std::string> excludeNames;  // 排除文件名（通配符，"re:"开头为正则）
+
+    // 把排除规则编译为匹配结构，修改规则后需重新调用；编译后的规则可被多个线程共享
+    void compile();
 
-    // 匹配文件是否符合规则
+    // 匹配文件是否符合规则（先读取元数据）
     bool match(const fs::path& filePath) const;
+    // 使用已读取的元数据匹配，不再访问文件系统
+    bool match(const fs::path& filePath, const FileMeta& meta) const;
+    // 除排除路径外的其余规则，name为文件名；遍历时排除路径由pathTrie()逐层检查
+    bool matchEntry(const std::string& name, const FileMeta& meta) const;
+    // 仅匹配文件类型，可在读取元数据前用目录项的d_type提前排除
+    bool matchType(mode_t mode) const;
+
+    // 编译后的排除路径前缀树，未编译时为空
+    const PathTrie* pathTrie() const { return m_pathTrie.get(); }
+
+private:
+    // compile()生成，未编译时为空
+    std::shared_ptr<const NameMatcher> m_nameMatcher;
+    std::shared_ptr<const PathTrie> m_pathTrie;
+    // 排除的用户/用户组解析为数字ID后的集合
+    struct OwnerSets {
+        std::unordered_set<uid_t> uids;
+        std::unordered_set<gid_t> gids;
+    };
+    std::shared_ptr<const OwnerSets> m_owners;
+
+    std::shared_ptr<const OwnerSets> resolveOwners() const;
 };
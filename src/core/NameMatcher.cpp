@@ -0,0 +1,219 @@
+#include "NameMatcher.h"
+#include <bitset>
+#include <algorithm>
+#include "spdlog/spdlog.h"
+
+using namespace std;
+
+namespace {
+
+const string kRegexPrefix = "re:";
+const size_t kStackWords = 8;   // 512个状态以内不在堆上分配状态向量
+
+// 通配符记号：'*'或单个字符位置（字面字符、'?'或字符类）
+struct GlobToken {
+    bool star = false;
+    bitset<256> chars;
+    int literal = -1;           // 字面字符，'?'与字符类为-1
+};
+
+// 解析[...]字符类，pos指向'['，成功时pos移到']'之后
+bool parseClass(const string& p, size_t& pos, bitset<256>& chars) {
+    size_t i = pos + 1;
+    bool negate = false;
+    if (i < p.size() && (p[i] == '!' || p[i] == '^')) {
+        negate = true;
+        i++;
+    }
+    bitset<256> set;
+    bool first = true;
+    while (i < p.size() && (p[i] != ']' || first)) {
+        first = false;
+        unsigned char lo = p[i];
+        if (lo == '\\' && i + 1 < p.size()) lo = p[++i];
+        i++;
+        if (i + 1 < p.size() && p[i] == '-' && p[i + 1] != ']') {
+            unsigned char hi = p[i + 1];
+            if (hi == '\\' && i + 2 < p.size()) hi = p[++i + 1];
+            i += 2;
+            for (unsigned c = lo; c <= hi; c++) set.set(c);
+        } else {
+            set.set(lo);
+        }
+    }
+    if (i >= p.size()) return false;   // 没有闭合的']'，按字面字符处理
+    chars = negate ? ~set : set;
+    pos = i + 1;
+    return true;
+}
+
+vector<GlobToken> parseGlob(const string& p) {
+    vector<GlobToken> tokens;
+    for (size_t i = 0; i < p.size();) {
+        GlobToken t;
+        char c = p[i];
+        if (c == '*') {
+            i++;
+            if (!tokens.empty() && tokens.back().star) continue;   // 连续的'*'合并
+            t.star = true;
+        } else if (c == '?') {
+            i++;
+            t.chars.set();
+        } else if (c == '[' && parseClass(p, i, t.chars)) {
+            // i已移到字符类之后
+        } else {
+            if (c == '\\' && i + 1 < p.size()) c = p[++i];
+            i++;
+            t.literal = (unsigned char)c;
+            t.chars.set((unsigned char)c);
+        }
+        tokens.push_back(t);
+    }
+    return tokens;
+}
+
+// 记号[from, to)全为字面字符时返回对应字符串
+bool literalRange(const vector<GlobToken>& tokens, size_t from, size_t to, string& out) {
+    out.clear();
+    for (size_t i = from; i < to; i++) {
+        if (tokens[i].literal < 0) return false;
+        out.push_back(char(tokens[i].literal));
+    }
+    return true;
+}
+
+void setBit(vector<uint64_t>& v, size_t offset, size_t bit) {
+    v[offset + bit / 64] |= uint64_t(1) << (bit % 64);
+}
+
+// out = (in << 1)，跨64位字进位
+inline void shiftLeft(const uint64_t* in, uint64_t* out, size_t words) {
+    for (size_t w = words; w-- > 0;) {
+        out[w] = (in[w] << 1) | (w > 0 ? in[w - 1] >> 63 : 0);
+    }
+}
+
+} // namespace
+
+void NameMatcher::AffixSet::add(const string& s) {
+    if (find(lengths.begin(), lengths.end(), s.size()) == lengths.end()) {
+        lengths.push_back(s.size());
+    }
+    values.insert(s);
+}
+
+NameMatcher::NameMatcher(const vector<string>& patterns) {
+    vector<vector<GlobToken>> nfaPatterns;
+
+    for (const auto& pattern : patterns) {
+        if (pattern.compare(0, kRegexPrefix.size(), kRegexPrefix) == 0) {
+            try {
+                m_regexes.emplace_back(pattern.substr(kRegexPrefix.size()), regex::optimize);
+                m_empty = false;
+            } catch (const regex_error& e) {
+                spdlog::warn("忽略无效的正则表达式：{}，{}", pattern, e.what());
+            }
+            continue;
+        }
+
+        m_empty = false;
+        vector<GlobToken> tokens = parseGlob(pattern);
+        size_t n = tokens.size();
+        size_t stars = count_if(tokens.begin(), tokens.end(), [](const GlobToken& t) { return t.star; });
+        string literal;
+
+        if (stars == 0 && literalRange(tokens, 0, n, literal)) {
+            m_exact.insert(literal);
+        } else if (stars == 1 && n == 1) {
+            m_matchAll = true;
+        } else if (stars == 1 && tokens[0].star && literalRange(tokens, 1, n, literal)) {
+            m_suffixes.add(literal);       // *.tmp
+        } else if (stars == 1 && tokens[n - 1].star && literalRange(tokens, 0, n - 1, literal)) {
+            m_prefixes.add(literal);       // core.*
+        } else {
+            nfaPatterns.push_back(std::move(tokens));
+        }
+    }
+
+    // 为所有复杂模式分配连续的状态位
+    for (const auto& tokens : nfaPatterns) m_bits += tokens.size() + 1;
+    if (m_bits == 0) return;
+    m_words = (m_bits + 63) / 64;
+    m_charMask.assign(256 * m_words, 0);
+    m_startMask.assign(m_words, 0);
+    m_starMask.assign(m_words, 0);
+    m_acceptMask.assign(m_words, 0);
+
+    size_t base = 0;
+    for (const auto& tokens : nfaPatterns) {
+        setBit(m_startMask, 0, base);
+        for (size_t i = 0; i < tokens.size(); i++) {
+            size_t state = base + i + 1;
+            if (tokens[i].star) {
+                setBit(m_starMask, 0, state);
+                continue;
+            }
+            for (unsigned c = 0; c < 256; c++) {
+                if (tokens[i].chars.test(c)) setBit(m_charMask, c * m_words, state);
+            }
+        }
+        setBit(m_acceptMask, 0, base + tokens.size());
+        base += tokens.size() + 1;
+    }
+}
+
+bool NameMatcher::match(const string& name) const {
+    if (m_empty) return false;
+    if (m_matchAll) return true;
+    if (!m_exact.empty() && m_exact.count(name)) return true;
+
+    for (size_t len : m_suffixes.lengths) {
+        if (len <= name.size() && m_suffixes.values.count(name.substr(name.size() - len))) return true;
+    }
+    for (size_t len : m_prefixes.lengths) {
+        if (len <= name.size() && m_prefixes.values.count(name.substr(0, len))) return true;
+    }
+
+    if (m_words > 0 && matchNfa(name)) return true;
+
+    for (const auto& re : m_regexes) {
+        if (regex_match(name, re)) return true;
+    }
+    return false;
+}
+
+bool NameMatcher::matchNfa(const string& name) const {
+    uint64_t stackBuf[2 * kStackWords];
+    vector<uint64_t> heapBuf;
+    uint64_t* state = stackBuf;
+    if (m_words > kStackWords) {
+        heapBuf.resize(2 * m_words);
+        state = heapBuf.data();
+    }
+    uint64_t* shifted = state + m_words;
+
+    // '*'可匹配空串：前一状态有效时'*'之后的状态同时有效
+    auto closure = [&] {
+        shiftLeft(state, shifted, m_words);
+        for (size_t w = 0; w < m_words; w++) state[w] |= shifted[w] & m_starMask[w];
+    };
+
+    copy(m_startMask.begin(), m_startMask.end(), state);
+    closure();
+    for (unsigned char c : name) {
+        const uint64_t* mask = &m_charMask[c * m_words];
+        shiftLeft(state, shifted, m_words);
+        uint64_t any = 0;
+        for (size_t w = 0; w < m_words; w++) {
+            state[w] = (shifted[w] & mask[w]) | (state[w] & m_starMask[w]);
+            any |= state[w];
+        }
+        if (!any) return false;   // 所有模式都已失配
+        closure();
+    }
+
+    for (size_t w = 0; w < m_words; w++) {
+        if (state[w] & m_acceptMask[w]) return true;
+    }
+    return false;
+}
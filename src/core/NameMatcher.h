@@ -0,0 +1,49 @@
+// NameMatcher.h
+#pragma once
+#include <string>
+#include <vector>
+#include <regex>
+#include <cstdint>
+#include <unordered_set>
+
+// 文件名多模式匹配器：构造时把所有排除模式编译一次，之后只读，可被多个线程共享。
+// 模式默认为通配符（* ? [abc] [a-z] [!x]，\转义），整个文件名匹配才算命中；
+// 以"re:"开头的模式按正则表达式处理。
+//   - 不含通配符的模式：哈希集合精确查找
+//   - "*后缀"、"前缀*" 模式（如 *.tmp）：按长度分组的哈希集合查找
+//   - 其余通配符模式：合并为一个位并行NFA（Shift-And），对文件名只扫描一遍
+class NameMatcher {
+public:
+    explicit NameMatcher(const std::vector<std::string>& patterns);
+
+    // name是否命中任一模式
+    bool match(const std::string& name) const;
+
+    bool empty() const { return m_empty; }
+
+private:
+    // 按长度分组的字符串集合，用于前缀/后缀查找
+    struct AffixSet {
+        std::vector<size_t> lengths;                 // 出现过的长度（去重）
+        std::unordered_set<std::string> values;
+        void add(const std::string& s);
+    };
+
+    bool matchNfa(const std::string& name) const;
+
+    bool m_empty = true;
+    std::unordered_set<std::string> m_exact;
+    AffixSet m_suffixes;
+    AffixSet m_prefixes;
+    bool m_matchAll = false;                         // 出现了单独的"*"
+
+    // 位并行NFA：第i位表示某个模式已匹配到第i个位置，每个模式占连续的(记号数+1)位
+    size_t m_words = 0;                              // 状态向量的64位字数
+    std::vector<uint64_t> m_charMask;                // 256 * m_words，字符c可推进的状态
+    std::vector<uint64_t> m_startMask;               // 各模式的起始状态
+    std::vector<uint64_t> m_starMask;                // '*'之后的状态：可自环，也可由前一状态直接到达
+    std::vector<uint64_t> m_acceptMask;              // 各模式的终止状态
+    size_t m_bits = 0;
+
+    std::vector<std::regex> m_regexes;
+};
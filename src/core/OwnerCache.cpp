@@ -0,0 +1,129 @@
+#include "OwnerCache.h"
+#include <map>
+#include <vector>
+#include <mutex>
+#include <shared_mutex>
+#include <cerrno>
+#include <cstdlib>
+#include <pwd.h>
+#include <grp.h>
+
+using namespace std;
+
+namespace {
+
+const size_t kInitialBufferSize = 4096;
+const size_t kMaxBufferSize = 1 << 20;
+
+// 一类ID的缓存：读多写少，命中时只加共享锁。std::map的元素地址不会变化，可以返回引用
+template <class Id>
+struct IdTable {
+    shared_mutex mutex;
+    map<Id, string> names;
+    map<string, pair<bool, Id>> ids;   // 未知名称也缓存，避免重复查询
+};
+
+IdTable<uid_t>& users() {
+    static IdTable<uid_t> table;
+    return table;
+}
+
+IdTable<gid_t>& groups() {
+    static IdTable<gid_t> table;
+    return table;
+}
+
+// 调用getpwuid_r一类的可重入查询，缓冲不足（ERANGE）时加倍重试；
+// 查到后在缓冲仍有效时调用extract取出需要的字段
+template <class Entry, class Query, class Extract>
+bool lookup(Query query, Extract extract) {
+    vector<char> buf(kInitialBufferSize);
+    while (true) {
+        Entry entry;
+        Entry* result = nullptr;
+        int err = query(&entry, buf.data(), buf.size(), &result);
+        if (err == ERANGE && buf.size() < kMaxBufferSize) {
+            buf.resize(buf.size() * 2);
+            continue;
+        }
+        if (err != 0 || result == nullptr) return false;
+        extract(entry);
+        return true;
+    }
+}
+
+bool parseNumericId(const string& name, unsigned long& id) {
+    if (name.empty() || name.find_first_not_of("0123456789") != string::npos) return false;
+    errno = 0;
+    id = strtoul(name.c_str(), nullptr, 10);
+    return errno == 0;
+}
+
+template <class Id, class Resolve>
+const string& cachedName(IdTable<Id>& table, Id id, Resolve resolve) {
+    {
+        shared_lock<shared_mutex> lock(table.mutex);
+        auto it = table.names.find(id);
+        if (it != table.names.end()) return it->second;
+    }
+    string name = resolve(id);   // 查询期间不持锁
+    unique_lock<shared_mutex> lock(table.mutex);
+    return table.names.emplace(id, std::move(name)).first->second;
+}
+
+template <class Id, class Resolve>
+bool cachedId(IdTable<Id>& table, const string& name, Id& id, Resolve resolve) {
+    unsigned long numeric;
+    if (parseNumericId(name, numeric)) {
+        id = Id(numeric);
+        return true;
+    }
+    {
+        shared_lock<shared_mutex> lock(table.mutex);
+        auto it = table.ids.find(name);
+        if (it != table.ids.end()) {
+            id = it->second.second;
+            return it->second.first;
+        }
+    }
+    Id resolved = 0;
+    bool found = resolve(name, resolved);
+    unique_lock<shared_mutex> lock(table.mutex);
+    table.ids.emplace(name, make_pair(found, resolved));
+    id = resolved;
+    return found;
+}
+
+} // namespace
+
+const string& OwnerCache::userName(uid_t uid) {
+    return cachedName(users(), uid, [](uid_t id) {
+        string name;
+        lookup<struct passwd>([id](struct passwd* e, char* b, size_t n, struct passwd** r) { return getpwuid_r(id, e, b, n, r); },
+                              [&name](const struct passwd& e) { name = e.pw_name; });
+        return name;
+    });
+}
+
+const string& OwnerCache::groupName(gid_t gid) {
+    return cachedName(groups(), gid, [](gid_t id) {
+        string name;
+        lookup<struct group>([id](struct group* e, char* b, size_t n, struct group** r) { return getgrgid_r(id, e, b, n, r); },
+                             [&name](const struct group& e) { name = e.gr_name; });
+        return name;
+    });
+}
+
+bool OwnerCache::userId(const string& name, uid_t& uid) {
+    return cachedId(users(), name, uid, [](const string& n, uid_t& id) {
+        return lookup<struct passwd>([&n](struct passwd* e, char* b, size_t len, struct passwd** r) { return getpwnam_r(n.c_str(), e, b, len, r); },
+                                     [&id](const struct passwd& e) { id = e.pw_uid; });
+    });
+}
+
+bool OwnerCache::groupId(const string& name, gid_t& gid) {
+    return cachedId(groups(), name, gid, [](const string& n, gid_t& id) {
+        return lookup<struct group>([&n](struct group* e, char* b, size_t len, struct group** r) { return getgrnam_r(n.c_str(), e, b, len, r); },
+                                    [&id](const struct group& e) { id = e.gr_gid; });
+    });
+}
@@ -0,0 +1,17 @@
+// OwnerCache.h
+#pragma once
+#include <string>
+#include <sys/types.h>
+
+// 用户/用户组名称与数字ID的双向缓存。查询经过NSS（可能是LDAP/sssd网络请求），
+// 每个ID或名称只解析一次；可在多个线程中同时调用
+class OwnerCache {
+public:
+    // 数字ID对应的名称，未知ID返回空串
+    static const std::string& userName(uid_t uid);
+    static const std::string& groupName(gid_t gid);
+
+    // 名称对应的数字ID，名称本身是十进制数字时直接作为ID；未知名称返回false
+    static bool userId(const std::string& name, uid_t& uid);
+    static bool groupId(const std::string& name, gid_t& gid);
+};
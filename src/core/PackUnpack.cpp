@@ -1,78 +1,704 @@
 #include "PackUnpack.h"
 #include <filesystem>
-#include <libtar.h>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <algorithm>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
 #include <fcntl.h>
 #include <unistd.h>
 #include <cerrno>
 #include <cstring>
+#include <climits>
+#include "OwnerCache.h"
 #include "spdlog/spdlog.h"
 
 namespace fs = std::filesystem;
 // 匹配头文件的命名空间
 namespace PackUnpack {
 
-// 原tarPack函数保持不变（内部辅助函数）
-bool tarPack(const std::vector<fs::path>& srcPaths, const std::string& destFile) {
-    TAR* tar = nullptr;
+// tar（GNU格式）流式写入器：每个条目为512字节头 + 按512字节对齐的数据
+class TarWriter {
+public:
+    explicit TarWriter(ByteSink& out) : m_out(out), m_buf(kStreamChunkSize) {}
 
-    if (tar_open(&tar, destFile.c_str(), NULL, O_WRONLY | O_CREAT, 0644, TAR_GNU) != 0) {
-        spdlog::error("无法创建tar归档文件：{}", destFile);
-        return false;
+    // 写入单个条目（目录不递归），归档内名称为name。
+    // 遍历之后被删除或无法读取的文件只警告并跳过（与DirWalker一致），返回false表示下游写入失败
+    bool appendFile(const fs::path& path, const std::string& name) {
+        struct stat st;
+        if (lstat(path.c_str(), &st) != 0) {
+            spdlog::warn("跳过无法读取的文件：{}，{}", path.string(), strerror(errno));
+            return true;
+        }
+        return appendEntry(path, name, st);
     }
 
-    // 遍历所有待打包路径
-    for (const auto& path : srcPaths) {
-        if (!fs::exists(path)) {
-            spdlog::error("路径不存在：{}", path.string());
-            tar_close(tar);
-            return false;
+    // 归档结束：两个全零块
+    bool close() {
+        char zero[kBlockSize * 2] = {};
+        return m_out.write(zero, sizeof(zero));
+    }
+
+private:
+    static const size_t kBlockSize = 512;
+
+    bool appendEntry(const fs::path& path, const std::string& name, const struct stat& st) {
+        char type;
+        std::string entryName = name;
+        std::string linkName;
+        uint64_t size = 0;
+        std::ifstream in;
+
+        if (S_ISREG(st.st_mode)) {
+            type = '0';
+            size = st.st_size;
+            // 硬链接只保存一份数据
+            auto key = std::make_pair(st.st_dev, st.st_ino);
+            auto it = st.st_nlink > 1 ? m_hardLinks.find(key) : m_hardLinks.end();
+            if (it != m_hardLinks.end()) {
+                type = '1';
+                linkName = it->second;
+                size = 0;
+            } else {
+                // 写头之前先打开文件，打不开时整个条目跳过
+                in.open(path, std::ios::binary);
+                if (!in.is_open()) {
+                    spdlog::warn("跳过无法读取的文件：{}，{}", path.string(), strerror(errno));
+                    return true;
+                }
+                if (st.st_nlink > 1) m_hardLinks.emplace(key, name);
+            }
+        } else if (S_ISDIR(st.st_mode)) {
+            type = '5';
+            entryName += "/";
+        } else if (S_ISLNK(st.st_mode)) {
+            type = '2';
+            std::vector<char> target(st.st_size > 0 ? st.st_size + 1 : PATH_MAX);
+            ssize_t n = readlink(path.c_str(), target.data(), target.size());
+            if (n < 0) {
+                spdlog::warn("跳过无法读取的符号链接：{}，{}", path.string(), strerror(errno));
+                return true;
+            }
+            linkName.assign(target.data(), n);
+        } else if (S_ISCHR(st.st_mode)) {
+            type = '3';
+        } else if (S_ISBLK(st.st_mode)) {
+            type = '4';
+        } else if (S_ISFIFO(st.st_mode)) {
+            type = '6';
+        } else {
+            spdlog::warn("跳过不支持的文件类型：{}", path.string());
+            return true;
         }
 
-        // 显式转换const char* to char*
-        char* realdir = const_cast<char*>(path.c_str());
-        char* savedir = const_cast<char*>(path.filename().c_str());
-        if (tar_append_tree(tar, realdir, savedir) != 0) {
-            spdlog::error("打包失败：{}", path.string());
-            tar_close(tar);
-            return false;
+        // 超长名称使用GNU扩展（././@LongLink）
+        if (linkName.size() > 100 && !writeLongName('K', linkName)) return false;
+        if (entryName.size() > 100 && !writeLongName('L', entryName)) return false;
+
+        char header[kBlockSize];
+        fillHeader(header, entryName, linkName, type, size, st);
+        if (!m_out.write(header, kBlockSize)) return false;
+
+        if (size > 0) return writeFileData(in, path, size);
+        return true;
+    }
+
+    bool writeLongName(char type, const std::string& longName) {
+        struct stat st = {};
+        char header[kBlockSize];
+        fillHeader(header, "././@LongLink", "", type, longName.size() + 1, st);
+        if (!m_out.write(header, kBlockSize)) return false;
+        if (!m_out.write(longName.c_str(), longName.size() + 1)) return false;
+        return writePadding(longName.size() + 1);
+    }
+
+    bool writeFileData(std::ifstream& in, const fs::path& path, uint64_t size) {
+        // 头中已写入大小，文件在打包过程中变化时按原大小截断或补零
+        uint64_t remaining = size;
+        while (remaining > 0) {
+            size_t n = std::min<uint64_t>(remaining, m_buf.size());
+            in.read(m_buf.data(), n);
+            size_t got = in.gcount();
+            if (got < n) {
+                spdlog::warn("文件在打包过程中被截断：{}", path.string());
+                std::fill(m_buf.begin() + got, m_buf.begin() + n, 0);
+                in.clear();
+                in.seekg(0, std::ios::end);
+            }
+            if (!m_out.write(m_buf.data(), n)) return false;
+            remaining -= n;
         }
+        return writePadding(size);
     }
 
-    // 关闭归档文件
-    if (tar_close(tar) != 0) {
-        spdlog::error("关闭tar归档文件失败：{}", destFile);
-        return false;
+    bool writePadding(uint64_t size) {
+        size_t pad = (kBlockSize - size % kBlockSize) % kBlockSize;
+        if (pad == 0) return true;
+        char zero[kBlockSize] = {};
+        return m_out.write(zero, pad);
     }
 
-    spdlog::info("tar打包成功：{}", destFile);
-    return true;
-}
-// 将 packFile 解包到 destDir 目录
-bool tarUnpack(const std::string& packFile, const std::string& destDir) {
+    // 数值字段：width-1位八进制数字加'\0'，超出范围时使用GNU的base-256编码
+    static void putNumber(char* field, size_t width, uint64_t value) {
+        if (value < (uint64_t(1) << (3 * (width - 1)))) {
+            field[width - 1] = '\0';
+            for (size_t i = width - 1; i > 0; i--) {
+                field[i - 1] = char('0' + (value & 7));
+                value >>= 3;
+            }
+            return;
+        }
+        memset(field, 0, width);
+        field[0] = char(0x80);
+        for (size_t i = width - 1; i > 0; i--) {
+            field[i] = char(value & 0xFF);
+            value >>= 8;
+        }
+    }
+
+    void fillHeader(char* header, const std::string& name, const std::string& linkName,
+                    char type, uint64_t size, const struct stat& st) {
+        memset(header, 0, kBlockSize);
+        memcpy(header, name.data(), std::min<size_t>(name.size(), 100));
+        putNumber(header + 100, 8, st.st_mode & 07777);
+        putNumber(header + 108, 8, st.st_uid);
+        putNumber(header + 116, 8, st.st_gid);
+        putNumber(header + 124, 12, size);
+        putNumber(header + 136, 12, st.st_mtime > 0 ? st.st_mtime : 0);
+        header[156] = type;
+        memcpy(header + 157, linkName.data(), std::min<size_t>(linkName.size(), 100));
+        memcpy(header + 257, "ustar  ", 8);   // GNU magic + version
+        if (type != 'L' && type != 'K') {
+            copyName(header + 265, OwnerCache::userName(st.st_uid));
+            copyName(header + 297, OwnerCache::groupName(st.st_gid));
+        }
+        if (type == '3' || type == '4') {
+            putNumber(header + 329, 8, major(st.st_rdev));
+            putNumber(header + 337, 8, minor(st.st_rdev));
+        }
+
+        // 校验和：计算时校验和字段按空格处理
+        memset(header + 148, ' ', 8);
+        unsigned int sum = 0;
+        for (size_t i = 0; i < kBlockSize; i++) sum += uint8_t(header[i]);
+        snprintf(header + 148, 8, "%06o", sum);
+        header[155] = ' ';
+    }
+
+    static void copyName(char* field, const std::string& name) {
+        memcpy(field, name.data(), std::min<size_t>(name.size(), 31));
+    }
+
+    ByteSink& m_out;
+    std::vector<char> m_buf;                                    // 文件读取缓冲
+    std::map<std::pair<dev_t, ino_t>, std::string> m_hardLinks; // 已写入的硬链接
+};
 
-    if(!fs::exists(destDir)) {
-        if(!fs::create_directories(destDir)){
-            spdlog::error("创建目标目录失败：{}", destDir);
+// tar流式解包器：边接收归档数据边在destDir下创建文件，不产生中间文件
+class TarReader : public ByteSink {
+public:
+    explicit TarReader(const fs::path& destDir) : m_destDir(destDir) {
+        m_destFd = open(destDir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (m_destFd < 0) {
+            spdlog::error("无法打开目标目录：{}，{}", destDir.string(), strerror(errno));
+            m_failed = true;
+        }
+    }
+
+    ~TarReader() override {
+        closeFile();
+        closeParent();
+        if (m_destFd >= 0) ::close(m_destFd);
+    }
+
+    bool write(const char* data, size_t len) override {
+        if (m_failed) return false;
+        while (len > 0 && !m_failed) {
+            size_t n;
+            switch (m_state) {
+            case State::Header:
+                n = std::min(len, kBlockSize - m_headerFill);
+                memcpy(m_header + m_headerFill, data, n);
+                m_headerFill += n;
+                if (m_headerFill == kBlockSize) {
+                    m_headerFill = 0;
+                    processHeader();
+                }
+                break;
+            case State::Data:
+                n = std::min<uint64_t>(len, m_remaining);
+                consumeData(data, n);
+                m_remaining -= n;
+                if (m_remaining == 0) endEntry();
+                break;
+            case State::Padding:
+                n = std::min<uint64_t>(len, m_remaining);
+                m_remaining -= n;
+                if (m_remaining == 0) m_state = State::Header;
+                break;
+            default:
+                // 结束标记之后的数据忽略
+                n = len;
+                break;
+            }
+            data += n;
+            len -= n;
+        }
+        return !m_failed;
+    }
+
+    bool finish() override {
+        if (m_failed) return false;
+        if (m_state != State::End && (m_state != State::Header || m_headerFill != 0)) {
+            spdlog::error("tar归档不完整");
             return false;
         }
+
+        // 目录内容写完后再设置目录的权限和时间，避免被后续写入覆盖
+        for (auto it = m_dirs.rbegin(); it != m_dirs.rend(); ++it) {
+            fs::path path = m_destDir / it->path;
+            int dirFd = parentDir(it->path.parent_path());
+            int fd = dirFd < 0 ? -1 : openat(dirFd, it->path.filename().c_str(),
+                                             O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+            if (fd < 0) {
+                spdlog::warn("无法还原目录属性：{}，{}", path.string(), strerror(errno));
+                continue;
+            }
+            applyAttributes(fd, path, it->attr);
+            ::close(fd);
+        }
+        m_dirs.clear();
+        spdlog::info("tar解包成功：{}", m_destDir.string());
+        return true;
+    }
+
+private:
+    static const size_t kBlockSize = 512;
+
+    enum class State { Header, Data, Padding, End };
+    enum class Target { None, File, LongName, LongLink, Pax };
+
+    struct Attributes {
+        mode_t mode = 0;
+        uid_t uid = 0;
+        gid_t gid = 0;
+        time_t mtime = 0;
+    };
+
+    struct DirEntry {
+        fs::path path;             // 相对目标目录的路径
+        Attributes attr;
+    };
+
+    static uint64_t parseNumber(const char* field, size_t width) {
+        // GNU base-256编码
+        if (uint8_t(field[0]) & 0x80) {
+            uint64_t value = uint8_t(field[0]) & 0x7F;
+            for (size_t i = 1; i < width; i++) value = (value << 8) | uint8_t(field[i]);
+            return value;
+        }
+        uint64_t value = 0;
+        for (size_t i = 0; i < width; i++) {
+            char c = field[i];
+            if (c == ' ') continue;
+            if (c < '0' || c > '7') break;
+            value = value * 8 + (c - '0');
+        }
+        return value;
+    }
+
+    static std::string parseString(const char* field, size_t width) {
+        return std::string(field, strnlen(field, width));
+    }
+
+    bool checksumValid() const {
+        unsigned int sum = 0;
+        int signedSum = 0;
+        for (size_t i = 0; i < kBlockSize; i++) {
+            char c = (i >= 148 && i < 156) ? ' ' : m_header[i];
+            sum += uint8_t(c);
+            signedSum += (signed char)c;
+        }
+        uint64_t stored = parseNumber(m_header + 148, 8);
+        return stored == sum || stored == uint64_t(signedSum);
+    }
+
+    void processHeader() {
+        bool allZero = std::all_of(m_header, m_header + kBlockSize, [](char c) { return c == 0; });
+        if (allZero) {
+            // 两个全零块表示归档结束
+            if (++m_zeroBlocks >= 2) m_state = State::End;
+            return;
+        }
+        m_zeroBlocks = 0;
+        if (!checksumValid()) {
+            spdlog::error("tar归档损坏：头部校验和错误");
+            m_failed = true;
+            return;
+        }
+
+        char type = m_header[156];
+        uint64_t size = parseNumber(m_header + 124, 12);
+        m_target = Target::None;
+        m_buffer.clear();
+
+        switch (type) {
+        case 'L':
+            m_target = Target::LongName;
+            break;
+        case 'K':
+            m_target = Target::LongLink;
+            break;
+        case 'x':
+            m_target = Target::Pax;
+            break;
+        case 'g':
+            break;
+        default:
+            startEntry(type);
+            break;
+        }
+        if (m_failed) return;
+
+        m_remaining = size;
+        m_entrySize = size;
+        if (size > 0) {
+            m_state = State::Data;
+        } else {
+            endEntry();
+        }
+    }
+
+    // 条目名称：优先使用GNU长名称/pax记录，其次为POSIX前缀 + 名称
+    std::string entryName() {
+        if (!m_longName.empty()) return std::move(m_longName);
+        std::string name = parseString(m_header, 100);
+        if (memcmp(m_header + 257, "ustar\0", 6) == 0 && m_header[345] != 0) {
+            name = parseString(m_header + 345, 155) + "/" + name;
+        }
+        return name;
     }
-    std::string command="tar -xf \"" + packFile + "\" -C \"" + destDir + "\" --overwrite";
-    
-    spdlog::info("执行命令：{}", command);
-    
-    int result = system(command.c_str());
-    
-    if (result == 0) {
+
+    std::string entryLink() {
+        if (!m_longLink.empty()) return std::move(m_longLink);
+        return parseString(m_header + 157, 100);
+    }
+
+    // 归档内路径转为destDir下的相对路径：与tar相同，绝对路径去掉开头的'/'后仍在destDir下还原，
+    // 含".."的路径跳过
+    bool resolvePath(const std::string& name, fs::path& out) {
+        fs::path rel;
+        for (const auto& part : fs::path(name).relative_path()) {
+            if (part == "..") {
+                spdlog::warn("跳过不安全的路径：{}", name);
+                return false;
+            }
+            if (part.empty() || part == ".") continue;
+            rel /= part;
+        }
+        if (rel.empty()) return false;
+        out = rel;
         return true;
-    } else {
-        spdlog::error("tar命令执行失败，返回码: {}", result);
+    }
+
+    // 从目标目录开始逐级打开相对路径dir，每一级都不跟随符号链接，create时创建缺少的目录。
+    // 归档中较早的符号链接因此不能把后续条目引到目标目录之外；返回新打开的fd，失败返回-1
+    int openDir(const fs::path& dir, bool create) {
+        const int flags = O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC;
+        int fd = fcntl(m_destFd, F_DUPFD_CLOEXEC, 0);
+        for (const auto& part : dir) {
+            if (fd < 0) break;
+            int next = openat(fd, part.c_str(), flags);
+            if (next < 0 && errno == ENOENT && create && (mkdirat(fd, part.c_str(), 0777) == 0 || errno == EEXIST)) {
+                next = openat(fd, part.c_str(), flags);
+            }
+            int err = errno;
+            ::close(fd);
+            errno = err;
+            fd = next;
+        }
+        return fd;
+    }
+
+    // 条目的父目录，与上一条目相同时复用已打开的fd（归档中同一目录的条目通常相邻）
+    int parentDir(const fs::path& dir) {
+        if (m_parentFd >= 0 && dir == m_parentPath) return m_parentFd;
+        closeParent();
+        m_parentFd = openDir(dir, true);
+        if (m_parentFd < 0) {
+            spdlog::error("无法打开目录（路径中不能含符号链接）：{}，{}", (m_destDir / dir).string(), strerror(errno));
+            return -1;
+        }
+        m_parentPath = dir;
+        return m_parentFd;
+    }
+
+    void startEntry(char type) {
+        std::string name = entryName();
+        std::string link = entryLink();
+        fs::path rel;
+        if (!resolvePath(name, rel)) return;
+        fs::path path = m_destDir / rel;
+        std::string leafName = rel.filename().string();
+        const char* leaf = leafName.c_str();
+
+        Attributes attr;
+        attr.mode = parseNumber(m_header + 100, 8) & 07777;
+        attr.uid = parseNumber(m_header + 108, 8);
+        attr.gid = parseNumber(m_header + 116, 8);
+        attr.mtime = parseNumber(m_header + 136, 12);
+
+        // 以下操作都相对父目录的fd进行，不经过路径中的符号链接
+        int dirFd = parentDir(rel.parent_path());
+        if (dirFd < 0) {
+            m_failed = true;
+            return;
+        }
+
+        struct stat st;
+        bool exists = fstatat(dirFd, leaf, &st, AT_SYMLINK_NOFOLLOW) == 0;
+        if (!exists && errno != ENOENT) {
+            spdlog::error("无法读取文件信息：{}，{}", path.string(), strerror(errno));
+            m_failed = true;
+            return;
+        }
+        bool isDir = exists && S_ISDIR(st.st_mode);
+
+        if (type == '5') {
+            if (!isDir) {
+                if ((exists && unlinkat(dirFd, leaf, 0) != 0) || mkdirat(dirFd, leaf, 0700) != 0) {
+                    spdlog::error("创建目录失败：{}，{}", path.string(), strerror(errno));
+                    m_failed = true;
+                    return;
+                }
+            }
+            m_dirs.push_back({rel, attr});
+            return;
+        }
+
+        // 覆盖已存在的文件（先删除，避免通过旧的符号链接写到别处）
+        if (exists && !isDir && unlinkat(dirFd, leaf, 0) != 0) {
+            spdlog::error("无法覆盖文件：{}，{}", path.string(), strerror(errno));
+            m_failed = true;
+            return;
+        }
+
+        switch (type) {
+        case '0':
+        case '\0':
+        case '7':
+            m_fd = openat(dirFd, leaf, O_WRONLY | O_CREAT | O_TRUNC | O_NOFOLLOW | O_CLOEXEC, 0600);
+            if (m_fd < 0) {
+                spdlog::error("创建文件失败：{}，{}", path.string(), strerror(errno));
+                m_failed = true;
+                return;
+            }
+            m_target = Target::File;
+            m_filePath = path;
+            m_fileAttr = attr;
+            return;
+        case '1': {
+            fs::path target;
+            int targetDir = -1;
+            bool ok = resolvePath(link, target) && (targetDir = openDir(target.parent_path(), false)) >= 0 &&
+                      linkat(targetDir, target.filename().c_str(), dirFd, leaf, 0) == 0;
+            if (!ok) {
+                spdlog::error("创建硬链接失败：{} -> {}，{}", path.string(), link, strerror(errno));
+                m_failed = true;
+            }
+            if (targetDir >= 0) ::close(targetDir);
+            return;
+        }
+        case '2':
+            if (symlinkat(link.c_str(), dirFd, leaf) != 0) {
+                spdlog::error("创建符号链接失败：{} -> {}，{}", path.string(), link, strerror(errno));
+                m_failed = true;
+                return;
+            }
+            applyLinkAttributes(dirFd, leaf, path, attr);
+            return;
+        case '3':
+        case '4':
+        case '6': {
+            mode_t kind = type == '3' ? S_IFCHR : (type == '4' ? S_IFBLK : S_IFIFO);
+            dev_t dev = makedev(parseNumber(m_header + 329, 8), parseNumber(m_header + 337, 8));
+            if (mknodat(dirFd, leaf, kind | attr.mode, dev) != 0) {
+                spdlog::warn("无法创建特殊文件：{}，{}", path.string(), strerror(errno));
+                return;
+            }
+            applyLinkAttributes(dirFd, leaf, path, attr);
+            return;
+        }
+        default:
+            spdlog::warn("跳过不支持的条目类型'{}'：{}", type, name);
+            return;
+        }
+    }
+
+    void consumeData(const char* data, size_t n) {
+        switch (m_target) {
+        case Target::File:
+            while (n > 0) {
+                ssize_t w = ::write(m_fd, data, n);
+                if (w < 0) {
+                    if (errno == EINTR) continue;
+                    spdlog::error("写入文件失败：{}，{}", m_filePath.string(), strerror(errno));
+                    m_failed = true;
+                    return;
+                }
+                data += w;
+                n -= w;
+            }
+            break;
+        case Target::LongName:
+        case Target::LongLink:
+        case Target::Pax:
+            m_buffer.append(data, n);
+            break;
+        default:
+            break;
+        }
+    }
+
+    void endEntry() {
+        switch (m_target) {
+        case Target::File:
+            applyAttributes(m_fd, m_filePath, m_fileAttr);
+            closeFile();
+            break;
+        case Target::LongName:
+            m_longName = parseString(m_buffer.data(), m_buffer.size());
+            break;
+        case Target::LongLink:
+            m_longLink = parseString(m_buffer.data(), m_buffer.size());
+            break;
+        case Target::Pax:
+            parsePax();
+            break;
+        default:
+            break;
+        }
+        m_target = Target::None;
+        m_remaining = (kBlockSize - m_entrySize % kBlockSize) % kBlockSize;
+        m_state = m_remaining > 0 ? State::Padding : State::Header;
+    }
+
+    // pax扩展头：每条记录为"长度 key=value\n"，只处理path与linkpath
+    void parsePax() {
+        size_t pos = 0;
+        while (pos < m_buffer.size()) {
+            size_t space = m_buffer.find(' ', pos);
+            if (space == std::string::npos) break;
+            size_t recLen = strtoul(m_buffer.c_str() + pos, nullptr, 10);
+            if (recLen == 0 || pos + recLen > m_buffer.size()) break;
+            std::string record = m_buffer.substr(space + 1, pos + recLen - space - 2);
+            size_t eq = record.find('=');
+            if (eq != std::string::npos) {
+                std::string key = record.substr(0, eq);
+                if (key == "path") m_longName = record.substr(eq + 1);
+                else if (key == "linkpath") m_longLink = record.substr(eq + 1);
+            }
+            pos += recLen;
+        }
+    }
+
+    void closeFile() {
+        if (m_fd >= 0) {
+            close(m_fd);
+            m_fd = -1;
+        }
+    }
+
+    void closeParent() {
+        if (m_parentFd >= 0) {
+            ::close(m_parentFd);
+            m_parentFd = -1;
+        }
+    }
+
+    // 恢复权限、时间，root用户还原属主（fd为已打开的文件或目录）
+    void applyAttributes(int fd, const fs::path& path, const Attributes& attr) {
+        if (geteuid() == 0 && fchown(fd, attr.uid, attr.gid) != 0) {
+            spdlog::warn("无法还原属主：{}，{}", path.string(), strerror(errno));
+        }
+        if (fchmod(fd, attr.mode) != 0) {
+            spdlog::warn("无法还原权限：{}，{}", path.string(), strerror(errno));
+        }
+        struct timespec times[2];
+        times[0].tv_sec = attr.mtime;
+        times[0].tv_nsec = 0;
+        times[1] = times[0];
+        futimens(fd, times);
+    }
+
+    // 符号链接和特殊文件：不跟随符号链接，权限在创建时已设置
+    void applyLinkAttributes(int dirFd, const char* name, const fs::path& path, const Attributes& attr) {
+        if (geteuid() == 0 && fchownat(dirFd, name, attr.uid, attr.gid, AT_SYMLINK_NOFOLLOW) != 0) {
+            spdlog::warn("无法还原属主：{}，{}", path.string(), strerror(errno));
+        }
+        struct timespec times[2];
+        times[0].tv_sec = attr.mtime;
+        times[0].tv_nsec = 0;
+        times[1] = times[0];
+        utimensat(dirFd, name, times, AT_SYMLINK_NOFOLLOW);
+    }
+
+    fs::path m_destDir;
+    int m_destFd = -1;             // 目标目录，所有条目都相对它逐级打开
+    int m_parentFd = -1;           // 上一条目的父目录
+    fs::path m_parentPath;         // m_parentFd相对目标目录的路径
+    State m_state = State::Header;
+    bool m_failed = false;
+    char m_header[kBlockSize];
+    size_t m_headerFill = 0;
+    int m_zeroBlocks = 0;
+    uint64_t m_entrySize = 0;
+    uint64_t m_remaining = 0;      // 当前条目剩余数据或填充字节数
+
+    Target m_target = Target::None;
+    std::string m_buffer;          // 长名称/pax数据
+    std::string m_longName;
+    std::string m_longLink;
+    int m_fd = -1;
+    fs::path m_filePath;
+    Attributes m_fileAttr;
+    std::vector<DirEntry> m_dirs;  // 结束时统一设置属性
+};
+
+// 流式tar打包：条目由遍历线程边筛选边送入队列
+bool tarPack(BoundedQueue<PackEntry>& entries, ByteSink& out) {
+    TarWriter tar(out);
+
+    PackEntry entry;
+    while (entries.pop(entry)) {
+        if (!tar.appendFile(entry.path, entry.name)) {
+            spdlog::error("打包失败：{}", entry.path.string());
+            return false;
+        }
+    }
+
+    if (!tar.close() || !out.finish()) {
+        spdlog::error("写入tar归档失败");
         return false;
     }
+    spdlog::info("tar打包成功");
+    return true;
+}
+
+// 创建流式tar解包器，数据解包到 destDir 目录
+std::unique_ptr<ByteSink> tarUnpacker(const std::string& destDir) {
+    std::error_code ec;
+    if (!fs::is_directory(destDir, ec) && !fs::create_directories(destDir, ec)) {
+        spdlog::error("创建目标目录失败：{}，{}", destDir, ec.message());
+        return nullptr;
+    }
+    return std::make_unique<TarReader>(destDir);
 }
 
-bool pack(const std::vector<fs::path>& srcPaths, const std::string& destFile, const std::string& packType) {
+bool pack(BoundedQueue<PackEntry>& entries, ByteSink& out, const std::string& packType) {
     if (packType == "tar") {
-        return tarPack(srcPaths, destFile);
+        return tarPack(entries, out);
     } else {
         spdlog::error("不支持的打包格式：{}", packType);
         return false;
@@ -80,12 +706,17 @@ bool pack(const std::vector<fs::path>& srcPaths, const std::string& destFile, co
 }
 
 bool unpack(const std::string& packFile, const std::string& destDir, const std::string& packType) {
+    auto unpacker = createUnpacker(destDir, packType);
+    return unpacker && pumpFile(packFile, *unpacker);
+}
+
+std::unique_ptr<ByteSink> createUnpacker(const std::string& destDir, const std::string& packType) {
     if (packType == "tar") {
-        return tarUnpack(packFile, destDir);
+        return tarUnpacker(destDir);
     } else {
         spdlog::error("不支持的解压格式：{}", packType);
-        return false;
+        return nullptr;
     }
 }
 
-} // 结束PackUnpack命名空间
\ No newline at end of file
+} // 结束PackUnpack命名空间
@@ -3,12 +3,25 @@
 #include <vector>
 #include <string>
 #include <filesystem>
+#include <memory>
+#include "Stream.h"
+#include "BoundedQueue.h"
 
 // 若BackupCore中使用了PackUnpack命名空间，需添加该命名空间
 namespace PackUnpack {
-    // 统一函数名为pack（与BackupCore调用一致）
-    bool pack(const std::vector<std::filesystem::path>& srcPaths, const std::string& destFile, const std::string& packType);
+    // 待打包条目：path为实际路径，name为归档内名称
+    struct PackEntry {
+        std::filesystem::path path;
+        std::string name;
+    };
+
+    // 流式打包：逐个取出entries中的条目写入out（目录不递归），队列关闭后调用out.finish()
+    bool pack(BoundedQueue<PackEntry>& entries, ByteSink& out, const std::string& packType);
 
     // 统一函数名为unpack（与BackupCore调用一致）
     bool unpack(const std::string& packFile, const std::string& destDir, const std::string& packType);
-}
\ No newline at end of file
+
+    // 流式解包：归档数据写入返回的阶段，直接在destDir下还原文件。
+    // 绝对路径的条目去掉开头的'/'后还原到destDir下，含".."的条目跳过
+    std::unique_ptr<ByteSink> createUnpacker(const std::string& destDir, const std::string& packType);
+}
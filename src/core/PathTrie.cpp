@@ -0,0 +1,87 @@
+#include "PathTrie.h"
+
+using namespace std;
+
+PathTrie::PathTrie(const vector<string>& paths) : m_nodes(2) {
+    for (const auto& path : paths) {
+        if (path.empty()) continue;
+        insert(path[0] == '/' ? kAbsRoot : kRelRoot, path);
+    }
+}
+
+void PathTrie::insert(uint32_t root, const string& path) {
+    uint32_t node = root;
+    size_t pos = 0;
+    bool any = false;
+    while (pos <= path.size()) {
+        size_t end = path.find('/', pos);
+        if (end == string::npos) end = path.size();
+        string name = path.substr(pos, end - pos);
+        pos = end + 1;
+        if (name.empty() || name == ".") continue;
+
+        auto it = m_nodes[node].children.find(name);
+        if (it != m_nodes[node].children.end()) {
+            node = it->second;
+        } else {
+            uint32_t next = uint32_t(m_nodes.size());
+            m_nodes[node].children.emplace(std::move(name), next);
+            m_nodes.emplace_back();
+            node = next;
+        }
+        any = true;
+    }
+    // "/"会排除整个文件系统，相对条目至少要有一个分量
+    if (any || root == kAbsRoot) {
+        m_nodes[node].terminal = true;
+        m_empty = false;
+    }
+}
+
+uint32_t PathTrie::child(uint32_t node, const string& name) const {
+    const auto& children = m_nodes[node].children;
+    if (children.empty()) return 0;
+    auto it = children.find(name);
+    return it == children.end() ? 0 : it->second;
+}
+
+bool PathTrie::start(const fs::path& absRoot, State& state) const {
+    state.clear();
+    if (m_empty) return true;
+    if (m_nodes[kAbsRoot].terminal) return false;
+
+    // 从文件系统根沿绝对路径逐个分量推进到遍历根目录，与excluded()的规则相同：
+    // 相对条目的匹配可以从根目录之上的某一层开始，如根目录为/a/src时"src/tmp"排除/a/src/tmp
+    State next;
+    state = {kAbsRoot};
+    for (const auto& part : absRoot.lexically_normal().relative_path()) {
+        string name = part.string();
+        if (name.empty()) continue;
+        if (!step(state, name, next)) return false;
+        state.swap(next);
+    }
+    return true;
+}
+
+bool PathTrie::step(const State& parent, const string& name, State& childState) const {
+    childState.clear();
+    if (m_empty) return true;
+
+    auto advance = [&](uint32_t from) {
+        uint32_t next = child(from, name);
+        if (next == 0) return true;
+        if (m_nodes[next].terminal) return false;
+        childState.push_back(next);
+        return true;
+    };
+    for (uint32_t node : parent) {
+        if (!advance(node)) return false;
+    }
+    // 相对条目可以从任意一层开始匹配
+    return advance(kRelRoot);
+}
+
+bool PathTrie::excluded(const fs::path& path) const {
+    State state;
+    return !start(fs::absolute(path), state);
+}
@@ -0,0 +1,49 @@
+// PathTrie.h
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <filesystem>
+#include <unordered_map>
+
+namespace fs = std::filesystem;
+
+// 排除路径前缀树：按路径分量（目录名）建树，遍历时随目录逐层推进，
+// 命中的目录在打开之前就被剪掉，整棵子树都不会被访问。
+//   - 以'/'开头的条目从文件系统根开始匹配，如 /home/user/.cache
+//   - 其余条目可匹配绝对路径中任意位置的连续分量，如 node_modules、build/tmp；
+//     遍历中的逐层检查与excluded()的单次检查使用同一规则，遍历根目录之上的分量也参与匹配
+class PathTrie {
+public:
+    // 匹配状态：当前目录对应的树节点（绝对路径匹配进度和相对条目的部分匹配）
+    using State = std::vector<uint32_t>;
+
+    explicit PathTrie(const std::vector<std::string>& paths);
+
+    bool empty() const { return m_empty; }
+
+    // 以遍历根目录absRoot（绝对路径）初始化状态，absRoot本身被排除时返回false
+    bool start(const fs::path& absRoot, State& state) const;
+
+    // 由父目录状态进入名为name的子条目，得到子条目的状态；子条目被排除时返回false
+    bool step(const State& parent, const std::string& name, State& child) const;
+
+    // 完整路径是否被排除（不在遍历中的单次检查，结果与从文件系统根逐层step相同）
+    bool excluded(const fs::path& path) const;
+
+private:
+    struct Node {
+        std::unordered_map<std::string, uint32_t> children;
+        bool terminal = false;   // 某个排除条目在此结束
+    };
+
+    static const uint32_t kAbsRoot = 0;
+    static const uint32_t kRelRoot = 1;
+
+    void insert(uint32_t root, const std::string& path);
+    // node的子节点name，不存在时返回0（根节点不会是任何节点的子节点）
+    uint32_t child(uint32_t node, const std::string& name) const;
+
+    std::vector<Node> m_nodes;
+    bool m_empty = true;
+};
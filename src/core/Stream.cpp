@@ -0,0 +1,128 @@
+#include "Stream.h"
+#include <vector>
+#include <exception>
+#include "spdlog/spdlog.h"
+
+using namespace std;
+
+FileByteSink::FileByteSink(const string& path)
+    : m_path(path), m_out(path, ios::binary | ios::trunc) {
+    if (!m_out.is_open()) {
+        spdlog::error("无法创建文件：{}", path);
+    }
+}
+
+bool FileByteSink::write(const char* data, size_t len) {
+    if (!m_out.is_open()) return false;
+    m_out.write(data, len);
+    return m_out.good();
+}
+
+bool FileByteSink::finish() {
+    if (!m_out.is_open()) return false;
+    m_out.close();
+    if (m_out.fail()) {
+        spdlog::error("写入文件失败：{}", m_path);
+        return false;
+    }
+    return true;
+}
+
+ThreadedSink::ThreadedSink(ByteSink& next, size_t bufferCount)
+    : m_next(next), m_filled(bufferCount), m_free(bufferCount) {
+    for (size_t i = 0; i < bufferCount; i++) {
+        vector<char> buf;
+        buf.reserve(kStreamChunkSize);
+        m_free.push(std::move(buf));
+    }
+    m_worker = thread(&ThreadedSink::run, this);
+}
+
+ThreadedSink::~ThreadedSink() {
+    if (!m_finished) {
+        m_aborted = true;
+        m_filled.close();
+    }
+    if (m_worker.joinable()) m_worker.join();
+}
+
+bool ThreadedSink::write(const char* data, size_t len) {
+    while (len > 0 && !m_failed) {
+        if (!m_hasCurrent) {
+            // 等待工作线程归还缓冲块
+            if (!m_free.pop(m_current)) return false;
+            m_current.clear();
+            m_hasCurrent = true;
+        }
+        size_t n = min(len, kStreamChunkSize - m_current.size());
+        m_current.insert(m_current.end(), data, data + n);
+        data += n;
+        len -= n;
+        if (m_current.size() == kStreamChunkSize) {
+            m_hasCurrent = false;
+            if (!m_filled.push(std::move(m_current))) return false;
+        }
+    }
+    return !m_failed;
+}
+
+bool ThreadedSink::finish() {
+    if (m_finished) return m_result;
+    if (m_hasCurrent && !m_current.empty()) {
+        m_filled.push(std::move(m_current));
+    }
+    m_hasCurrent = false;
+    m_finished = true;
+    m_filled.close();
+    m_worker.join();
+    return m_result;
+}
+
+// 在工作线程中调用下游阶段：异常无法传回调用线程（逸出线程函数会直接终止进程），记录后按失败处理
+template <class F>
+static bool callGuarded(F&& f) {
+    try {
+        return f();
+    } catch (const exception& e) {
+        spdlog::error("流水线阶段异常：{}", e.what());
+    } catch (...) {
+        spdlog::error("流水线阶段异常：未知错误");
+    }
+    return false;
+}
+
+void ThreadedSink::run() {
+    vector<char> buf;
+    bool ok = true;
+    while (m_filled.pop(buf)) {
+        // 出错后继续取出并归还缓冲块，避免上游阻塞
+        if (ok && !callGuarded([&] { return m_next.write(buf.data(), buf.size()); })) {
+            ok = false;
+            m_failed = true;
+        }
+        buf.clear();
+        m_free.push(std::move(buf));
+    }
+    if (ok && !m_aborted) ok = callGuarded([&] { return m_next.finish(); });
+    m_result = ok && !m_aborted;
+}
+
+bool pumpFile(const string& path, ByteSink& out) {
+    ifstream in(path, ios::binary);
+    if (!in.is_open()) {
+        spdlog::error("无法打开文件：{}", path);
+        return false;
+    }
+
+    vector<char> buf(kStreamChunkSize);
+    while (in) {
+        in.read(buf.data(), buf.size());
+        streamsize n = in.gcount();
+        if (n > 0 && !out.write(buf.data(), n)) return false;
+    }
+    if (in.bad()) {
+        spdlog::error("读取文件失败：{}", path);
+        return false;
+    }
+    return out.finish();
+}
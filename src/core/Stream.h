@@ -0,0 +1,67 @@
+// Stream.h
+#pragma once
+#include <string>
+#include <fstream>
+#include <cstddef>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include "BoundedQueue.h"
+
+// 流水线各阶段之间传递的缓冲块大小（1MB）
+constexpr size_t kStreamChunkSize = 1 << 20;
+
+// 流水线阶段接口：上游调用write推送数据，数据全部推送完毕后调用finish
+class ByteSink {
+public:
+    virtual ~ByteSink() = default;
+
+    // 写入一段数据，下游出错时返回false
+    virtual bool write(const char* data, size_t len) = 0;
+
+    // 数据结束：刷新本阶段缓冲，并依次结束下游阶段
+    virtual bool finish() = 0;
+};
+
+// 流水线终点：写入磁盘文件
+class FileByteSink : public ByteSink {
+public:
+    explicit FileByteSink(const std::string& path);
+
+    bool isOpen() const { return m_out.is_open(); }
+    bool write(const char* data, size_t len) override;
+    bool finish() override;
+
+private:
+    std::string m_path;
+    std::ofstream m_out;
+};
+
+// 在独立线程中运行下游阶段：write把数据拷入可复用的缓冲块，经有界队列交给工作线程，
+// 使上下游阶段（读盘、压缩、加密、写盘）并行执行，内存占用为bufferCount个缓冲块
+class ThreadedSink : public ByteSink {
+public:
+    explicit ThreadedSink(ByteSink& next, size_t bufferCount = 4);
+    ~ThreadedSink() override;
+
+    bool write(const char* data, size_t len) override;
+    // 提交剩余数据并等待工作线程结束下游
+    bool finish() override;
+
+private:
+    void run();
+
+    ByteSink& m_next;
+    BoundedQueue<std::vector<char>> m_filled;   // 待下游处理的缓冲块
+    BoundedQueue<std::vector<char>> m_free;     // 处理完毕、可复用的缓冲块
+    std::vector<char> m_current;                // 当前正在填充的缓冲块
+    bool m_hasCurrent = false;
+    bool m_finished = false;
+    std::atomic<bool> m_failed{false};          // 下游出错
+    std::atomic<bool> m_aborted{false};         // 未调用finish即析构
+    bool m_result = false;
+    std::thread m_worker;
+};
+
+// 按kStreamChunkSize分块读取文件推入下游，读完后调用out.finish()
+bool pumpFile(const std::string& path, ByteSink& out);
@@ -4,6 +4,9 @@
 #include "core/BackupCore.h"
 #include <signal.h>
 #include <filesystem>
+#include <cstdlib>
+#include <cstring>
+#include <charconv>
 #include "spdlog/spdlog.h"
 
 bool isCliMode = false;
@@ -30,9 +33,12 @@ int main(int argc, char *argv[]) {
     if (isCliMode) {
         // 命令行模式（复用之前的逻辑，无需修改）
         std::cout << "===== 数据备份软件（命令行模式）=====" << std::endl;
-        std::cout << "支持命令：" << std::endl;
-        std::cout << "  backup --src 源路径 --dest 目标路径 [--pack 打包算法] [--compress 压缩算法] [--crypto 加密算法] [--password 密码]" << std::endl;
-        std::cout << "  restore --file 备份文件 --dest 还原路径 [--crypto 加密算法] [--password 密码]" << std::endl;
+        auto printUsage = [] {
+            std::cout << "支持命令：" << std::endl;
+            std::cout << "  backup --src 源路径 --dest 目标路径 [--pack 打包算法] [--compress 压缩算法] [--level 压缩级别1-9] [--dict] [--crypto 加密算法] [--password 密码]" << std::endl;
+            std::cout << "  restore --file 备份文件 --dest 还原路径 [--crypto 加密算法] [--password 密码]" << std::endl;
+        };
+        printUsage();
 
         BackupCore core;
         BackupCore::BackupConfig config;
@@ -47,6 +53,19 @@ int main(int argc, char *argv[]) {
                     else if (key == "--dest" && j + 1 < argc) config.destPath = argv[++j];
                     else if (key == "--pack" && j + 1 < argc) config.packAlg = argv[++j];
                     else if (key == "--compress" && j + 1 < argc) config.compressAlg = argv[++j];
+                    else if (key == "--level" && j + 1 < argc) {
+                        // 整个参数必须是1-9的整数，"abc"、"6x"等直接报错
+                        const char* text = argv[++j];
+                        const char* end = text + std::strlen(text);
+                        auto result = std::from_chars(text, end, config.compressLevel);
+                        if (result.ec != std::errc() || result.ptr != end ||
+                            config.compressLevel < Compress::kMinLevel || config.compressLevel > Compress::kMaxLevel) {
+                            spdlog::error("错误：无效的压缩级别：{}（{}-{}）", text, Compress::kMinLevel, Compress::kMaxLevel);
+                            printUsage();
+                            return 1;
+                        }
+                    }
+                    else if (key == "--dict") config.compressDict = true;
                     else if (key == "--crypto" && j + 1 < argc) config.cryptoAlg = argv[++j];
                     else if (key == "--password" && j + 1 < argc) config.password = argv[++j];
                 }
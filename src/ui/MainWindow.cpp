@@ -22,6 +22,8 @@ MainWindow::MainWindow()
       m_destEntry(),
       m_packCombo(),
       m_compressCombo(),
+      m_levelCombo(),
+      m_dictCheck("Dictionary"),
       m_cryptoCombo(),
       m_pwdEntry(),
       m_pwdVisibleBtn("Show Password"),
@@ -293,18 +295,29 @@ MainWindow::MainWindow()
     m_packCombo.set_active(0);
     m_compressCombo.append("LZ77");
     m_compressCombo.append("Haff");
+    m_compressCombo.append("LZH");
+    m_compressCombo.append("ANS");
+    m_compressCombo.append("LZA");
     m_compressCombo.set_active(0);
+    for (int level = Compress::kMinLevel; level <= Compress::kMaxLevel; level++) {
+        m_levelCombo.append(std::to_string(level));
+    }
+    m_levelCombo.set_active(Compress::kDefaultLevel - Compress::kMinLevel);
     m_cryptoCombo.append("AES");
     m_cryptoCombo.append("DES");
     m_cryptoCombo.set_active(0);
 
     Gtk::Label packLabel("Pack Alg:");
     Gtk::Label compressLabel("Compress Alg:");
+    Gtk::Label levelLabel("Level:");
     Gtk::Label cryptoLabel("Crypto Alg:");
     m_algBox.pack_start(packLabel, Gtk::PACK_SHRINK);
     m_algBox.pack_start(m_packCombo, Gtk::PACK_SHRINK);
     m_algBox.pack_start(compressLabel, Gtk::PACK_SHRINK);
     m_algBox.pack_start(m_compressCombo, Gtk::PACK_SHRINK);
+    m_algBox.pack_start(levelLabel, Gtk::PACK_SHRINK);
+    m_algBox.pack_start(m_levelCombo, Gtk::PACK_SHRINK);
+    m_algBox.pack_start(m_dictCheck, Gtk::PACK_SHRINK);
     m_algBox.pack_start(cryptoLabel, Gtk::PACK_SHRINK);
     m_algBox.pack_start(m_cryptoCombo, Gtk::PACK_SHRINK);
     m_mainBox.pack_start(m_algBox, Gtk::PACK_SHRINK);
@@ -615,6 +628,8 @@ void MainWindow::on_backup_clicked() {
 
     m_backupConfig.packAlg = std::string(m_packCombo.get_active_text());
     m_backupConfig.compressAlg = std::string(m_compressCombo.get_active_text());
+    m_backupConfig.compressLevel = Compress::kMinLevel + m_levelCombo.get_active_row_number();
+    m_backupConfig.compressDict = m_dictCheck.get_active();
     m_backupConfig.cryptoAlg = std::string(m_cryptoCombo.get_active_text());
     m_backupConfig.password = std::string(m_pwdEntry.get_text());
     m_backupConfig.filterRule = getFilterRule();
@@ -24,6 +24,8 @@ private:
     Gtk::Entry m_srcEntry, m_destEntry;  // 7. Path input boxes
     Gtk::ComboBoxText m_packCombo;
     Gtk::ComboBoxText m_compressCombo;
+    Gtk::ComboBoxText m_levelCombo;      // 压缩级别（1-9）
+    Gtk::CheckButton m_dictCheck;        // 训练压缩字典
     Gtk::ComboBoxText m_cryptoCombo;
     Gtk::Entry m_pwdEntry;               // 11. Password input box
     Gtk::CheckButton m_pwdVisibleBtn;    // 12. Password visibility toggle (New)
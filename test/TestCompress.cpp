@@ -0,0 +1,497 @@
+// 压缩格式测试：通过Compress.h的流式接口压缩再解压，检查各算法的往返、
+// test/data中存档文件的解码，以及截断和损坏的输入。
+// 用法：TestCompress [测试数据目录]，默认为data
+#include <string>
+#include <vector>
+#include <map>
+#include <queue>
+#include <algorithm>
+#include "Compress.h"
+#include "spdlog/spdlog.h"
+#include "TestUtil.h"
+
+using namespace std;
+
+static const size_t kThreads = 4;
+static string g_dataDir = "data";
+
+static bool compressString(const string& alg, const string& input, int level, size_t threads,
+                           const string& dictionary, string& packed) {
+    StringSink sink;
+    auto compressor = Compress::createCompressor(alg, sink, level, threads, dictionary);
+    if (!compressor || !compressor->write(input.data(), input.size()) || !compressor->finish()) return false;
+    packed = std::move(sink.m_data);
+    return true;
+}
+
+static bool compressString(const string& alg, const string& input, string& packed) {
+    return compressString(alg, input, Compress::kDefaultLevel, 1, string(), packed);
+}
+
+// 解压：输入按pieceSize切成小段依次写入，检验跨段的增量解析
+static bool decompressString(const string& alg, const string& packed, size_t threads, string& output,
+                             size_t pieceSize = 1 << 20) {
+    StringSink sink;
+    auto decompressor = Compress::createDecompressor(alg, sink, threads);
+    if (!decompressor) return false;
+    for (size_t pos = 0; pos < packed.size(); pos += pieceSize) {
+        if (!decompressor->write(packed.data() + pos, min(pieceSize, packed.size() - pos))) return false;
+    }
+    if (!decompressor->finish()) return false;
+    output = std::move(sink.m_data);
+    return true;
+}
+
+// 单线程压缩再解压，结果与原始数据一致
+static bool roundTrip(const string& alg, const string& input) {
+    string packed, output;
+    return compressString(alg, input, packed) && decompressString(alg, packed, 1, output) && output == input;
+}
+
+// 跨越多个块的混合数据：文本（可压缩）、随机数据（原样存储块）、全零（长匹配）
+static string mixedData(mt19937& rng) {
+    return randomText(rng, 100 << 10) + randomBytes(rng, 150 << 10) + string(300 << 10, '\0') +
+           randomText(rng, 100 << 10);
+}
+
+// 按顺序列出压缩数据中各块的方法（文件头之后每块为：方法、标志、原始长度、压缩长度、数据），不含结束块
+static vector<uint8_t> blockMethods(const string& packed) {
+    vector<uint8_t> methods;
+    for (size_t pos = 6; pos + 10 <= packed.size();) {
+        uint8_t method = uint8_t(packed[pos]);
+        if (method == 0) break;
+        uint32_t packedSize = 0;
+        for (int i = 0; i < 4; i++) packedSize |= uint32_t(uint8_t(packed[pos + 6 + i])) << (8 * i);
+        methods.push_back(method);
+        pos += 10 + packedSize;
+    }
+    return methods;
+}
+
+// 解码测试数据目录中的存档文件（由sample.txt压缩而来），输入分别按1字节、100字节和整块写入
+static void checkArchive(const string& file, const string& alg) {
+    string expected, packed, output;
+    if (!readFile(g_dataDir + "/sample.txt", expected) || !readFile(g_dataDir + "/" + file, packed)) {
+        check(false, "无法读取测试数据：" + g_dataDir + "/" + file);
+        return;
+    }
+    for (size_t pieceSize : {size_t(1), size_t(100), size_t(1) << 20}) {
+        bool ok = decompressString(alg, packed, 1, output, pieceSize);
+        check(ok && output == expected, file + " 解码不一致（每段" + to_string(pieceSize) + "字节）");
+    }
+}
+
+// 损坏的输入：截断必须报错，随机改写字节不能崩溃（解码错误日志太多，暂时关闭）
+static void checkCorruption(mt19937& rng, const string& alg, const string& input, size_t threads) {
+    string packed, output;
+    if (!compressString(alg, input, packed)) {
+        check(false, alg + " 压缩失败");
+        return;
+    }
+    spdlog::set_level(spdlog::level::off);
+    for (size_t cut : {size_t(5), size_t(20), packed.size() / 2, packed.size() - 1}) {
+        check(!decompressString(alg, packed.substr(0, cut), threads, output),
+              alg + " 截断到" + to_string(cut) + "字节没有报错（" + to_string(threads) + "线程）");
+    }
+    for (int i = 0; i < 100; i++) {
+        string corrupt = packed;
+        for (int k = 0; k < 4; k++) corrupt[rng() % corrupt.size()] = char(rng());
+        decompressString(alg, corrupt, threads, output);
+    }
+    spdlog::set_level(spdlog::level::info);
+}
+
+// 旧的整文件格式（不以"FBKZ"开头，最初版本的程序生成）：按算法名自动改用旧格式解码
+static void testLegacy() {
+    checkArchive("legacy.lz77", "LZ77");
+    checkArchive("legacy.haff", "Haff");
+}
+
+// LZ77序列格式：随机数据不会膨胀（旧格式每字节5字节），固定的存档文件保证格式不变
+static void testLz77Format(mt19937& rng) {
+    string random = randomBytes(rng, 1 << 20), packed;
+    check(compressString("LZ77", random, packed) && packed.size() < random.size() + random.size() / 100,
+          "LZ77 随机数据膨胀到" + to_string(packed.size()) + "字节");
+    for (const string& input : {string(), string("x"), string(1000, 'a'), mixedData(rng)}) {
+        check(roundTrip("LZ77", input), "LZ77 往返不一致（" + to_string(input.size()) + "字节）");
+    }
+    checkCorruption(rng, "LZ77", mixedData(rng), 1);
+    checkArchive("format.lz77", "LZ77");
+}
+
+// 26种字节按Fibonacci数列的频率出现（约31万字节，打乱顺序），不限制码长时最长编码约25位
+static string fibonacciData(mt19937& rng) {
+    string data;
+    uint32_t a = 1, b = 1;
+    for (int c = 0; c < 26 * 7; c += 7) {
+        data.append(a, char(c));
+        swap(a, b);
+        b += a;
+    }
+    shuffle(data.begin(), data.end(), rng);
+    return data;
+}
+
+// 按最初版本的哈夫曼格式编码：字符数、每个字符及其频率，之后是编码位（高位在前），
+// 末尾为最后一字节的有效位数。建树顺序与旧程序相同：频率小的先合并，频率相同时比较子树中最小的字符
+static string legacyHaff(const string& input) {
+    map<char, uint32_t> freq;
+    for (char c : input) freq[c]++;
+
+    struct Node {
+        char data, minChar;
+        uint32_t freq;
+        int left, right;
+    };
+    vector<Node> nodes;
+    auto greater = [&](int a, int b) {
+        return nodes[a].freq != nodes[b].freq ? nodes[a].freq > nodes[b].freq : nodes[a].minChar > nodes[b].minChar;
+    };
+    priority_queue<int, vector<int>, decltype(greater)> heap(greater);
+    for (const auto& f : freq) {
+        nodes.push_back({f.first, f.first, f.second, -1, -1});
+        heap.push(int(nodes.size()) - 1);
+    }
+    while (heap.size() > 1) {
+        int left = heap.top();
+        heap.pop();
+        int right = heap.top();
+        heap.pop();
+        nodes.push_back({'\0', min(nodes[left].minChar, nodes[right].minChar), nodes[left].freq + nodes[right].freq,
+                         left, right});
+        heap.push(int(nodes.size()) - 1);
+    }
+
+    // 左0右1，由根出发逐层求出每个字符的编码
+    map<char, string> codes;
+    vector<pair<int, string>> stack;
+    if (nodes.size() > 1) stack.push_back({int(nodes.size()) - 1, ""});
+    while (!stack.empty()) {
+        auto [node, code] = stack.back();
+        stack.pop_back();
+        if (nodes[node].left < 0) {
+            codes[nodes[node].data] = code;
+            continue;
+        }
+        stack.push_back({nodes[node].left, code + "0"});
+        stack.push_back({nodes[node].right, code + "1"});
+    }
+
+    string out;
+    auto putU32 = [&](uint32_t v) {
+        for (int i = 0; i < 4; i++) out.push_back(char(v >> (8 * i)));
+    };
+    putU32(uint32_t(freq.size()));
+    for (const auto& f : freq) {
+        out.push_back(f.first);
+        putU32(f.second);
+    }
+    uint8_t byte = 0;
+    int bits = 0;
+    for (char c : input) {
+        for (char b : codes[c]) {
+            byte = uint8_t(byte << 1 | (b == '1'));
+            if (++bits % 8 == 0) out.push_back(char(byte));
+        }
+    }
+    if (bits % 8) out.push_back(char(byte << (8 - bits % 8)));
+    out.push_back(char(bits % 8 ? bits % 8 : 8));
+    return out;
+}
+
+// 旧格式哈夫曼查表解码：长于查表位数的编码（Fibonacci频率，最长约25位）逐位走树，
+// 输入任意切段时编码可以在段中间断开
+static void testHaffDecoder(mt19937& rng) {
+    string fib = fibonacciData(rng);
+
+    // 测试用的编码与旧程序一致：重新编码sample.txt得到与legacy.haff相同的文件
+    string sample, legacy;
+    check(readFile(g_dataDir + "/sample.txt", sample) && readFile(g_dataDir + "/legacy.haff", legacy) &&
+          legacyHaff(sample) == legacy, "旧格式哈夫曼编码与legacy.haff不同");
+
+    for (const string& input : {fib, randomText(rng, 300 << 10), randomBytes(rng, 100 << 10), string(5000, 'z'),
+                                string("ab"), string()}) {
+        string packed = legacyHaff(input), output;
+        for (size_t pieceSize : {size_t(1), size_t(7), size_t(1) << 20}) {
+            bool ok = decompressString("Haff", packed, 1, output, pieceSize);
+            check(ok && output == input, "旧格式哈夫曼解码不一致（" + to_string(input.size()) + "字节，每段" +
+                                         to_string(pieceSize) + "字节）");
+        }
+    }
+}
+
+// 哈夫曼编码：各种长度（含0-100字节和块边界附近）与分布（单一符号到全部256种）的往返，
+// 编码累加器每满32位写出一次，末尾不足一字的位必须完整写出
+static void testHaffEncoder(mt19937& rng) {
+    for (size_t size = 0; size <= 100; size++) {
+        check(roundTrip("Haff", randomBytes(rng, size, 1 + size % 20)), "Haff 往返不一致（" + to_string(size) + "字节）");
+    }
+    const size_t block = 128 << 10;
+    for (size_t size : {block - 1, block, block + 1, 3 * block + 5}) {
+        check(roundTrip("Haff", randomText(rng, size)), "Haff 块边界附近往返不一致（" + to_string(size) + "字节）");
+    }
+    for (unsigned alphabet : {1u, 2u, 3u, 16u, 200u, 256u}) {
+        check(roundTrip("Haff", randomBytes(rng, 300 << 10, alphabet)),
+              "Haff " + to_string(alphabet) + "种符号往返不一致");
+    }
+
+    string text = randomText(rng, 1 << 20), packed;
+    check(compressString("Haff", text, packed) && packed.size() < text.size() * 3 / 4,
+          "Haff 文本没有被压缩（" + to_string(packed.size()) + "字节）");
+}
+
+// 范式哈夫曼块：块头之后是128字节的码长表（每个字节值4位），码长不超过12位。
+// Fibonacci频率下的码长被限制，单一符号的块只有码长表，无效的码长表被拒绝
+static void testCanonical(mt19937& rng) {
+    const size_t kBlockOffset = 6;                 // 文件头之后的第一个块头
+    const size_t kTableOffset = kBlockOffset + 10;
+    const uint8_t kBlockHaffCanon = 5;
+    auto maxLength = [&](const string& packed) {
+        int longest = 0;
+        for (size_t i = kTableOffset; i < kTableOffset + 128; i++) {
+            longest = max({longest, uint8_t(packed[i]) & 0x0F, uint8_t(packed[i]) >> 4});
+        }
+        return longest;
+    };
+
+    string fib = fibonacciData(rng), packed;
+    check(compressString("Haff", fib, packed) && packed.size() > kTableOffset + 128 &&
+          uint8_t(packed[kBlockOffset]) == kBlockHaffCanon && maxLength(packed) <= 12,
+          "Fibonacci频率的码长没有被限制在12位以内");
+    check(roundTrip("Haff", fib), "Fibonacci频率往返不一致");
+
+    string single(128 << 10, 'z');
+    check(compressString("Haff", single, packed) && packed.size() < kTableOffset + 128 + 32,
+          "单一符号的块有" + to_string(packed.size()) + "字节");
+
+    // 码长表全为1（违反Kraft不等式）或出现超过12的码长：报错而不是越界
+    string text = randomText(rng, 100 << 10), output;
+    check(compressString("Haff", text, packed) && uint8_t(packed[kBlockOffset]) == kBlockHaffCanon, "Haff 压缩失败");
+    spdlog::set_level(spdlog::level::off);
+    string corrupt = packed;
+    fill(corrupt.begin() + kTableOffset, corrupt.begin() + kTableOffset + 128, char(0x11));
+    check(!decompressString("Haff", corrupt, 1, output), "违反Kraft不等式的码长表没有报错");
+    corrupt = packed;
+    corrupt[kTableOffset + 'e' / 2] = char(0xDD);
+    check(!decompressString("Haff", corrupt, 1, output), "超过12位的码长没有报错");
+    spdlog::set_level(spdlog::level::info);
+
+    checkArchive("format.haff", "Haff");
+}
+
+// 分块自适应哈夫曼：每128KB块单独统计频率，编码无效的块原样存储；分段写入与一次写入结果相同
+static void testHaffBlocks(mt19937& rng) {
+    const size_t block = 128 << 10;
+    const uint8_t kStored = 1, kHaffCanon = 5;
+    string packed, pieces;
+    string mixed = randomText(rng, 2 * block) + randomBytes(rng, 2 * block);
+    check(compressString("Haff", mixed, packed) &&
+          blockMethods(packed) == vector<uint8_t>{kHaffCanon, kHaffCanon, kStored, kStored},
+          "文本块没有编码或随机数据块没有原样存储");
+    check(roundTrip("Haff", mixed), "Haff 混合数据往返不一致");
+
+    // 前后两块各用4种不同的字节：每块单独的码表约2位/字节，整体一张表需要3位
+    string shifted = randomBytes(rng, block, 4);
+    for (char c : randomBytes(rng, block, 4)) shifted.push_back(char(c + 20));
+    check(compressString("Haff", shifted, packed) && packed.size() < shifted.size() * 2 / 8 + 1024,
+          "分块码表没有适应数据变化（" + to_string(packed.size()) + "字节）");
+
+    StringSink sink;
+    auto compressor = Compress::createCompressor("Haff", sink);
+    bool ok = true;
+    for (size_t pos = 0; ok && pos < mixed.size(); pos += 777) {
+        ok = compressor->write(mixed.data() + pos, min<size_t>(777, mixed.size() - pos));
+    }
+    check(compressor->finish() && ok && compressString("Haff", mixed, packed) && sink.m_data == packed,
+          "分段写入的压缩结果不同");
+}
+
+// 分块并行压缩：各块只依赖原始数据，多线程压缩的结果与单线程完全相同，按块顺序写出
+static void testParallel(mt19937& rng) {
+    string input = mixedData(rng) + randomText(rng, 3 << 20);
+    for (const char* alg : {"LZ77", "Haff", "LZH", "ANS", "LZA"}) {
+        string single, parallel, output;
+        bool ok = compressString(alg, input, Compress::kDefaultLevel, 1, string(), single) &&
+                  compressString(alg, input, Compress::kDefaultLevel, kThreads, string(), parallel);
+        check(ok && single == parallel, string(alg) + " 多线程压缩结果与单线程不同");
+        check(decompressString(alg, parallel, 1, output) && output == input, string(alg) + " 多线程压缩的数据解压不一致");
+    }
+}
+
+// LZH（LZ77序列再做哈夫曼编码）：文本上比单独的LZ77和哈夫曼都小；未知的算法名得到nullptr
+static void testLzh(mt19937& rng) {
+    string text = randomText(rng, 2 << 20), lzh, lz77, haff;
+    check(compressString("LZH", text, lzh) && compressString("LZ77", text, lz77) && compressString("Haff", text, haff) &&
+          lzh.size() < lz77.size() && lzh.size() < haff.size(),
+          "LZH没有比LZ77和Haff更小（" + to_string(lzh.size()) + " / " + to_string(lz77.size()) + " / " +
+          to_string(haff.size()) + "）");
+    for (const string& input : {string(), string("x"), string(1 << 20, 'a'), mixedData(rng)}) {
+        check(roundTrip("LZH", input), "LZH 往返不一致（" + to_string(input.size()) + "字节）");
+    }
+    checkCorruption(rng, "LZH", mixedData(rng), 1);
+    checkArchive("format.lzh", "LZH");
+
+    StringSink sink;
+    spdlog::set_level(spdlog::level::off);
+    check(!Compress::createCompressor("LZX", sink) && !Compress::createDecompressor("LZX", sink),
+          "未知的算法名没有报错");
+    spdlog::set_level(spdlog::level::info);
+}
+
+// 不可压缩数据：各算法都原样存储，只多出块头；高熵数据中的长距离重复LZ类算法仍能匹配到
+static void testIncompressible(mt19937& rng) {
+    const uint8_t kStored = 1;
+    string random = randomBytes(rng, 3 << 20);
+    string chunk = randomBytes(rng, 400 << 10), repeated = chunk + chunk;
+    for (const char* alg : {"LZ77", "Haff", "LZH", "ANS", "LZA"}) {
+        string packed;
+        bool ok = compressString(alg, random, packed);
+        vector<uint8_t> methods = blockMethods(packed);
+        check(ok && packed.size() < random.size() + random.size() / 1000 && !methods.empty() &&
+              count(methods.begin(), methods.end(), kStored) == ptrdiff_t(methods.size()),
+              string(alg) + " 随机数据没有原样存储（" + to_string(packed.size()) + "字节）");
+
+        bool lz = string(alg).find("LZ") == 0;
+        check(compressString(alg, repeated, packed) && (!lz || packed.size() < chunk.size() + chunk.size() / 10),
+              string(alg) + " 高熵数据中的重复没有被匹配（" + to_string(packed.size()) + "字节）");
+        check(roundTrip(alg, repeated), string(alg) + " 高熵重复数据往返不一致");
+    }
+}
+
+// 压缩级别：LZ类算法在最快、默认和最高级别都能往返，级别越高文本上的结果越小；
+// 超出范围的级别不创建压缩阶段
+static void testLevels(mt19937& rng) {
+    string text = randomText(rng, 256 << 10), mixed = mixedData(rng);
+    for (const char* alg : {"LZ77", "LZH", "LZA"}) {
+        size_t sizes[3] = {};
+        int i = 0;
+        for (int level : {Compress::kMinLevel, Compress::kDefaultLevel, Compress::kMaxLevel}) {
+            string packed, output;
+            bool ok = compressString(alg, text, level, 1, string(), packed) &&
+                      decompressString(alg, packed, 1, output) && output == text;
+            sizes[i++] = packed.size();
+            check(ok && compressString(alg, mixed, level, 1, string(), packed) &&
+                  decompressString(alg, packed, 1, output) && output == mixed,
+                  string(alg) + " 级别" + to_string(level) + "往返不一致");
+        }
+        check(sizes[2] <= sizes[1] && sizes[1] < sizes[0],
+              string(alg) + " 级别越高结果没有越小（" + to_string(sizes[0]) + " / " + to_string(sizes[1]) + " / " +
+              to_string(sizes[2]) + "）");
+    }
+
+    StringSink sink;
+    spdlog::set_level(spdlog::level::off);
+    check(!Compress::createCompressor("LZ77", sink, Compress::kMinLevel - 1) &&
+          !Compress::createCompressor("LZ77", sink, Compress::kMaxLevel + 1), "超出范围的压缩级别没有报错");
+    spdlog::set_level(spdlog::level::info);
+}
+
+// 预置字典：许多小文件共用的内容由字典提供，每个文件开头就能匹配；字典保存在压缩数据中，
+// 解压时不需要另外提供。哈夫曼/rANS不使用字典，结果不变
+static void testDictionary(mt19937& rng) {
+    string boilerplate = randomText(rng, 3000);
+    vector<string> files;
+    for (int i = 0; i < 200; i++) {
+        files.push_back(boilerplate.substr(rng() % 1000, 1500) + randomBytes(rng, 200, 16));
+    }
+    string dictionary = Compress::trainDictionary(files);
+    check(!dictionary.empty() && dictionary.size() <= Compress::kDefaultDictSize,
+          "字典大小为" + to_string(dictionary.size()) + "字节");
+
+    // 比较单个文件压缩后的大小（减去空数据时的文件头和字典块）
+    for (const char* alg : {"LZ77", "LZH", "LZA"}) {
+        string empty, emptyDict, packed, output;
+        bool ok = compressString(alg, "", Compress::kDefaultLevel, 1, string(), empty) &&
+                  compressString(alg, "", Compress::kDefaultLevel, 1, dictionary, emptyDict);
+        size_t plain = 0, withDict = 0;
+        for (size_t i = 0; ok && i < 20; i++) {
+            ok = compressString(alg, files[i], packed);
+            plain += packed.size() - empty.size();
+            ok = ok && compressString(alg, files[i], Compress::kDefaultLevel, 1, dictionary, packed) &&
+                 decompressString(alg, packed, 1, output) && output == files[i];
+            withDict += packed.size() - emptyDict.size();
+        }
+        check(ok && withDict * 2 < plain, string(alg) + " 字典没有明显减小小文件（" + to_string(withDict) + " / " +
+                                         to_string(plain) + "）");
+
+        // 跨多块、多线程压缩，每块都以字典开头的历史窗口
+        string mixed = mixedData(rng), single, parallel;
+        check(compressString(alg, mixed, Compress::kDefaultLevel, 1, dictionary, single) &&
+              compressString(alg, mixed, Compress::kDefaultLevel, kThreads, dictionary, parallel) &&
+              single == parallel && decompressString(alg, parallel, 1, output) && output == mixed,
+              string(alg) + " 带字典的多块数据往返不一致");
+    }
+
+    // 大于窗口一半的字典被截断（级别1的窗口为64KB）
+    string big = randomText(rng, 100 << 10), packed, output;
+    check(compressString("LZ77", files[0], Compress::kMinLevel, 1, big, packed) &&
+          decompressString("LZ77", packed, 1, output) && output == files[0], "超长字典往返不一致");
+
+    for (const char* alg : {"Haff", "ANS"}) {
+        string plain, withDict;
+        check(compressString(alg, files[0], Compress::kDefaultLevel, 1, string(), plain) &&
+              compressString(alg, files[0], Compress::kDefaultLevel, 1, dictionary, withDict) && plain == withDict,
+              string(alg) + " 的结果受字典影响");
+    }
+
+    checkArchive("format_dict.lzh", "LZH");
+}
+
+// rANS（ANS为单独的熵编码，LZA为LZ77序列再做rANS编码）
+static void testRans(mt19937& rng) {
+    string mixed = mixedData(rng);
+    for (const char* alg : {"ANS", "LZA"}) {
+        for (const string& input : {string(), string("x"), mixed, randomBytes(rng, 200 << 10, 16)}) {
+            check(roundTrip(alg, input), string(alg) + " 往返不一致（" + to_string(input.size()) + "字节）");
+        }
+        checkCorruption(rng, alg, mixed, 1);
+    }
+
+    // 分布很偏时符号可以占小数位：p=0.95的两种字节，熵约0.29位/字节，哈夫曼每字节至少1位
+    string skewed(512 << 10, 'a');
+    for (auto& c : skewed) {
+        if (rng() % 100 < 5) c = 'b';
+    }
+    string ans, haff;
+    check(compressString("ANS", skewed, ans) && compressString("Haff", skewed, haff) && ans.size() * 2 < haff.size(),
+          "偏斜分布上ANS没有明显小于Haff（" + to_string(ans.size()) + " / " + to_string(haff.size()) + "）");
+    check(roundTrip("ANS", skewed), "ANS 偏斜分布往返不一致");
+
+    checkArchive("format.ans", "ANS");
+    checkArchive("format.lza", "LZA");
+}
+
+// 并行解码：哈夫曼/rANS的各块同时解码后按顺序写出，结果与单线程相同；
+// 输入切成小段时块可能跨段，截断和损坏的数据在多线程下同样报错而不是卡住
+static void testParallelDecode(mt19937& rng) {
+    string input = mixedData(rng) + randomText(rng, 2 << 20);
+    for (const char* alg : {"Haff", "ANS", "LZ77", "LZH", "LZA"}) {
+        string packed, single, parallel, pieces;
+        check(compressString(alg, input, Compress::kDefaultLevel, kThreads, string(), packed) &&
+              decompressString(alg, packed, 1, single) && decompressString(alg, packed, kThreads, parallel) &&
+              decompressString(alg, packed, kThreads, pieces, 777) && single == input && parallel == input &&
+              pieces == input, string(alg) + " 多线程解码不一致");
+        checkCorruption(rng, alg, mixedData(rng), kThreads);
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1) g_dataDir = argv[1];
+    mt19937 rng(20240601);
+
+    testLegacy();
+    testLz77Format(rng);
+    testHaffDecoder(rng);
+    testHaffEncoder(rng);
+    testCanonical(rng);
+    testHaffBlocks(rng);
+    testParallel(rng);
+    testLzh(rng);
+    testIncompressible(rng);
+    testLevels(rng);
+    testDictionary(rng);
+    testRans(rng);
+    testParallelDecode(rng);
+
+    return testResult("压缩");
+}
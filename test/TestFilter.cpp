@@ -0,0 +1,297 @@
+// 筛选与遍历测试：多线程目录遍历访问每个条目恰好一次，筛选规则在遍历中和单独匹配时结果一致
+#include <string>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <filesystem>
+#include <fcntl.h>
+#include <fnmatch.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "DirWalker.h"
+#include "OwnerCache.h"
+#include "spdlog/spdlog.h"
+#include "TestUtil.h"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+static fs::path g_root;
+
+// 用DirWalker遍历root，返回排序后的相对路径
+static vector<string> walkTree(const fs::path& root, const FilterRule& rule, size_t threads) {
+    vector<string> found;
+    mutex m;
+    DirWalker walker(rule, threads);
+    bool ok = walker.walk(root, [&](const fs::path& path, const string& relPath, const FileMeta&) {
+        lock_guard<mutex> lock(m);
+        check(path == root / relPath, "遍历回调的路径与相对路径不对应：" + relPath);
+        found.push_back(relPath);
+        return true;
+    });
+    check(ok, "遍历失败：" + root.string());
+    sort(found.begin(), found.end());
+    return found;
+}
+
+// 不跟随符号链接列出root下的全部条目
+static vector<string> listTree(const fs::path& root) {
+    vector<string> all;
+    for (auto it = fs::recursive_directory_iterator(root); it != fs::recursive_directory_iterator(); ++it) {
+        all.push_back(it->path().lexically_relative(root).string());
+    }
+    sort(all.begin(), all.end());
+    return all;
+}
+
+// 规则在遍历中（DirWalker逐层检查）与单独匹配（match）时选中相同的条目
+static void checkRule(const fs::path& root, const FilterRule& rule, const vector<string>& expected,
+                      const string& what) {
+    check(walkTree(root, rule, 2) == expected, what + "：遍历结果不正确");
+    vector<string> matched;
+    for (const auto& name : listTree(root)) {
+        if (rule.match(root / name)) matched.push_back(name);
+    }
+    check(matched == expected, what + "：match结果不正确");
+}
+
+// 多线程遍历：每个条目恰好访问一次，不进入指向目录的符号链接，回调返回false时停止
+static void testWalker() {
+    fs::path root = g_root / "walk";
+    for (int i = 0; i < 40; i++) {
+        fs::path dir = root / ("d" + to_string(i % 5)) / ("e" + to_string(i));
+        if (i % 3 == 0) dir /= "deep/deeper";
+        fs::create_directories(dir);
+        for (int k = 0; k < 25; k++) writeFile(dir / ("f" + to_string(k)), to_string(k));
+    }
+    fs::create_directories(root / "empty");
+    fs::create_directory_symlink(root / "d0", root / "link_to_dir");
+    vector<string> expected = listTree(root);
+
+    FilterRule rule;
+    for (size_t threads : {size_t(1), size_t(4), size_t(0)}) {
+        check(walkTree(root, rule, threads) == expected, "遍历结果与目录树不一致（" + to_string(threads) + "线程）");
+    }
+
+    // 回调返回false：walk返回false，不再继续交付条目
+    size_t calls = 0;
+    mutex m;
+    DirWalker walker(rule, 4);
+    bool ok = walker.walk(root, [&](const fs::path&, const string&, const FileMeta&) {
+        lock_guard<mutex> lock(m);
+        return ++calls < 10;
+    });
+    check(!ok && calls < expected.size() / 2, "回调返回false后遍历没有停止（" + to_string(calls) + "次回调）");
+
+    // 根目录不存在时只警告，不交付任何条目
+    spdlog::set_level(spdlog::level::off);
+    check(walkTree(g_root / "missing", rule, 2).empty(), "不存在的根目录交付了条目");
+    spdlog::set_level(spdlog::level::info);
+}
+
+// 元数据与类型/大小/时间规则：一次statx读取，不跟随符号链接；遍历中与单独匹配结果一致
+static void testMeta() {
+    fs::path root = g_root / "meta";
+    fs::create_directories(root / "dir");
+    writeFile(root / "small.txt", string(10, 'x'));
+    writeFile(root / "big.txt", string(5000, 'x'));
+    fs::create_symlink("big.txt", root / "link");
+    struct timespec old[2] = {{1000000000, 0}, {1000000000, 0}};
+    utimensat(AT_FDCWD, (root / "small.txt").c_str(), old, 0);
+
+    FileMeta meta;
+    check(FileMeta::load(AT_FDCWD, (root / "link").c_str(), meta) && S_ISLNK(meta.mode), "符号链接被跟随");
+    check(FileMeta::load(AT_FDCWD, (root / "big.txt").c_str(), meta) && S_ISREG(meta.mode) && meta.size == 5000 &&
+          meta.uid == getuid() && meta.createTime > 0, "普通文件的元数据不正确");
+    check(FileMeta::load(AT_FDCWD, (root / "small.txt").c_str(), meta) && meta.modifyTime == 1000000000,
+          "修改时间不正确");
+    check(!FileMeta::load(AT_FDCWD, (root / "missing").c_str(), meta), "不存在的文件读取元数据成功");
+
+    FilterRule rule;
+    rule.includeTypes = {"-"};
+    checkRule(root, rule, {"big.txt", "small.txt"}, "只包含普通文件");
+    rule.includeTypes = {"l"};
+    checkRule(root, rule, {"link"}, "只包含符号链接");
+    rule.includeTypes = {"d"};
+    checkRule(root, rule, {"dir"}, "只包含目录");
+
+    // 大小只限制普通文件
+    rule = FilterRule();
+    rule.minSize = 100;
+    checkRule(root, rule, {"big.txt", "dir", "link"}, "最小大小");
+    rule.minSize = 0;
+    rule.maxSize = 100;
+    checkRule(root, rule, {"dir", "link", "small.txt"}, "最大大小");
+
+    rule = FilterRule();
+    rule.maxModifyTime = 1500000000;
+    checkRule(root, rule, {"small.txt"}, "最大修改时间");
+    rule = FilterRule();
+    rule.minModifyTime = 1500000000;
+    checkRule(root, rule, {"big.txt", "dir", "link"}, "最小修改时间");
+
+    bool thrown = false;
+    try {
+        rule.match(root / "missing");
+    } catch (const fs::filesystem_error&) {
+        thrown = true;
+    }
+    check(thrown, "不存在的文件匹配时没有报错");
+}
+
+// 文件名模式：各类通配符与fnmatch(3)结果一致，多个模式合并后（状态超过64位）与逐个匹配一致
+static void testNames(mt19937& rng) {
+    vector<string> globs = {"core", "*.tmp", "*.o", "~*", "build-*", "a?c", "*a*b*", "[a-c]x*", "[!a]*.c",
+                            "\\*star", "x\\?y", "*[0-9][0-9]", "?", "??*.log", "a*a*a*a*b", "[]]z", "[a-]*q",
+                            "ab[c", ".*rc", "*.tar.*", "[[:x]*"};
+    // 随机名称的字符集覆盖模式中出现的特殊字符
+    const string alphabet = "abcxyzq.0159~-*?[]\\";
+    vector<string> names = {"", "core", "core.1", "x.tmp", ".tmp", "tmp", "a.o", "~backup", "build-", "abc", "axc",
+                            "ac", "xaybz", "bxz", "b.c", "a.c", "*star", "\\star", "x?y", "xzy", "f12", "f1",
+                            "z", "ab.log", "a.log", "aaaab", "aab", "]z", "-q", "ab[c", ".bashrc", "x.tar.gz"};
+    for (int i = 0; i < 3000; i++) {
+        string name;
+        for (size_t n = rng() % 8; n > 0; n--) name += alphabet[rng() % alphabet.size()];
+        names.push_back(name);
+    }
+
+    NameMatcher all(globs);
+    for (const auto& name : names) {
+        bool any = false;
+        for (const auto& glob : globs) {
+            bool expected = fnmatch(glob.c_str(), name.c_str(), 0) == 0;
+            any = any || expected;
+            check(NameMatcher({glob}).match(name) == expected, "模式" + glob + "匹配\"" + name + "\"的结果不正确");
+        }
+        check(all.match(name) == any, "合并后的模式匹配\"" + name + "\"的结果不正确");
+    }
+
+    // 状态位跨多个64位字：许多复杂模式合并后与逐个fnmatch的结果一致
+    vector<string> many;
+    for (int i = 0; i < 100; i++) many.push_back("p" + to_string(i) + "*[0-9]?x");
+    NameMatcher wide(many);
+    for (const char* name : {"p99_5_x", "p7abc3zx", "p5_5x", "q1_5_x", "p42", "p42x5yx", "p1005x"}) {
+        bool expected = any_of(many.begin(), many.end(),
+                               [&](const string& glob) { return fnmatch(glob.c_str(), name, 0) == 0; });
+        check(wide.match(name) == expected, string("超过64个状态的模式匹配\"") + name + "\"的结果不正确");
+    }
+
+    // "re:"开头为正则表达式，无效的正则只警告并忽略
+    spdlog::set_level(spdlog::level::off);
+    NameMatcher regexes({"re:.*\\.(bak|swp)", "re:(", "re:[0-9]+"});
+    NameMatcher invalid({"re:(unclosed"});
+    spdlog::set_level(spdlog::level::info);
+    check(regexes.match("a.bak") && regexes.match("x.swp") && regexes.match("123") && !regexes.match("a.bak1") &&
+          !regexes.match("12a"), "正则表达式模式匹配不正确");
+    check(invalid.empty() && !invalid.match("(unclosed"), "无效的正则表达式没有被忽略");
+    check(NameMatcher({}).empty() && !NameMatcher({}).match("x") && NameMatcher({"*"}).match(""),
+          "空模式集或单独的*匹配不正确");
+
+    // 遍历时按文件名排除，目录名也参与匹配
+    fs::path root = g_root / "names";
+    fs::create_directories(root / "obj.tmp");
+    writeFile(root / "obj.tmp" / "inner.c", "");
+    writeFile(root / "keep.c", "");
+    writeFile(root / "drop.o", "");
+    FilterRule rule;
+    rule.excludeNames = {"*.o", "*.tmp"};
+    check(walkTree(root, rule, 2) == vector<string>{"keep.c", "obj.tmp/inner.c"}, "按文件名排除的遍历结果不正确");
+}
+
+// 排除路径：绝对条目从文件系统根匹配，相对条目匹配绝对路径中任意位置的连续分量（包括遍历根目录之上的部分），
+// 遍历时被排除的目录不再进入
+static void testPaths() {
+    fs::path root = g_root / "paths" / "src";
+    for (const char* dir : {"tmp", "lib/tmp", "lib/node_modules/pkg", "cache/x", "app/src/tmp"}) {
+        fs::create_directories(root / dir);
+    }
+    writeFile(root / "main.c", "");
+    writeFile(root / "lib" / "tmp" / "t.c", "");
+    writeFile(root / "lib" / "node_modules" / "pkg" / "index.js", "");
+
+    FilterRule rule;
+    rule.excludePaths = {"src/tmp", "node_modules", (root / "cache").string()};
+    checkRule(root, rule, {"app", "app/src", "lib", "lib/tmp", "lib/tmp/t.c", "main.c"}, "排除路径");
+
+    // 目录名中的部分字符不算匹配，条目末尾的'/'和"."被忽略
+    rule.excludePaths = {"ib", "lib/./tmp/", "/" + root.relative_path().string() + "/app/"};
+    checkRule(root, rule, {"cache", "cache/x", "lib", "lib/node_modules", "lib/node_modules/pkg",
+                           "lib/node_modules/pkg/index.js", "main.c", "tmp"}, "排除路径的分量匹配");
+
+    // 遍历根目录本身被排除
+    rule.excludePaths = {"paths/src"};
+    checkRule(root, rule, {}, "遍历根目录被排除");
+    rule.excludePaths = {"paths"};
+    checkRule(root, rule, {}, "遍历根目录的上级被排除");
+}
+
+// 用户/用户组：名称与数字ID双向缓存，未知ID和名称不出错；排除规则按数字ID匹配
+static void testOwners() {
+    check(OwnerCache::userName(0) == "root" && OwnerCache::groupName(0) == "root", "ID 0的名称不是root");
+    check(&OwnerCache::userName(0) == &OwnerCache::userName(0), "名称没有被缓存");
+    check(OwnerCache::userName(3999999999u).empty() && OwnerCache::groupName(3999999999u).empty(),
+          "未知ID的名称不为空");
+
+    uid_t uid = 1;
+    gid_t gid = 1;
+    check(OwnerCache::userId("root", uid) && uid == 0 && OwnerCache::groupId("root", gid) && gid == 0,
+          "root的ID不是0");
+    check(OwnerCache::userId("12345", uid) && uid == 12345 && OwnerCache::groupId("54321", gid) && gid == 54321,
+          "数字名称没有直接作为ID");
+    check(!OwnerCache::userId("no_such_user_fbk", uid) && !OwnerCache::userId("no_such_user_fbk", uid) &&
+          !OwnerCache::groupId("no_such_group_fbk", gid), "未知名称解析成功");
+
+    // 多个线程同时查询，结果与单线程一致（check不是线程安全的，先计数）
+    atomic<int> mismatches{0};
+    vector<thread> threads;
+    for (int t = 0; t < 8; t++) {
+        threads.emplace_back([t, &mismatches] {
+            for (uid_t i = 0; i < 200; i++) {
+                uid_t id = (i * 7 + t) % 200, back;
+                const string& name = OwnerCache::userName(id);
+                if (!name.empty() && !(OwnerCache::userId(name, back) && back == id)) mismatches++;
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+    check(mismatches == 0, "并发查询的结果不一致：" + to_string(mismatches.load()) + "次");
+
+    // 排除当前用户（按名称或数字）/用户组后不选中任何文件；未知名称的规则被忽略
+    fs::path root = g_root / "owners";
+    fs::create_directories(root / "dir");
+    writeFile(root / "dir" / "file", "");
+    FilterRule rule;
+    rule.excludeUsers = {to_string(getuid())};
+    checkRule(root, rule, {}, "按数字uid排除");
+    rule.excludeUsers = {OwnerCache::userName(getuid())};
+    checkRule(root, rule, {}, "按用户名排除");
+    rule.excludeUsers.clear();
+    rule.excludeGroups = {OwnerCache::groupName(getgid())};
+    checkRule(root, rule, {}, "按用户组排除");
+    spdlog::set_level(spdlog::level::off);
+    rule.excludeGroups = {"no_such_group_fbk"};
+    rule.excludeUsers = {"no_such_user_fbk", "12345"};
+    checkRule(root, rule, {"dir", "dir/file"}, "排除其他用户");
+    spdlog::set_level(spdlog::level::info);
+}
+
+int main() {
+    mt19937 rng(20240605);
+    g_root = makeTempDir();
+    if (g_root.empty()) {
+        cout << "无法创建临时目录" << endl;
+        return 1;
+    }
+
+    testWalker();
+    testMeta();
+    testNames(rng);
+    testPaths();
+    testOwners();
+
+    std::error_code ec;
+    fs::remove_all(g_root, ec);
+    return testResult("筛选");
+}
@@ -1,132 +1,227 @@
-#include <iostream>
-#include <fstream>
+// LZ77测试：通过Compress.h的流式接口压缩再解压，覆盖每个压缩级别（即四种匹配查找配置：
+// 1为fast，2为greedy，3为greedy-full，4-9为lazy）和单线程/多线程压缩
 #include <string>
 #include <vector>
-#include <algorithm>
-#include <iomanip>
+#include <cstring>
+#include <sys/resource.h>
+#include "Compress.h"
+#include "TestUtil.h"
 
 using namespace std;
 
-class LZ77Compress{
-private:
-    static const int WINDOW_SIZE = 4096;      // 滑动窗口大小
-    static const int LOOKAHEAD_SIZE = 18;     // 前向缓冲区大小
-    // LZ77编码结构体：(偏移量, 匹配长度, 下一个字符)
-    struct LZ77Token {
-        int offset;      // 偏移量
-        int length;      // 匹配长度
-        char nextChar;   // 下一个字符
-        
-        LZ77Token(int o = 0, int l = 0, char c = '\0') 
-            : offset(o), length(l), nextChar(c) {}
-    };
-    
-    // 在滑动窗口中查找最长匹配
-    LZ77Token findLongestMatch(const string& data, int pos) {
-        int windowStart = max(0, pos - WINDOW_SIZE);
-        int matchOffset = 0;
-        int matchLength = 0;
-        
-        // 在滑动窗口中搜索最长匹配
-        for (int i = windowStart; i < pos; i++) {
-            int length = 0;
-            // 计算从位置i开始的匹配长度
-            while (length < LOOKAHEAD_SIZE && 
-                   pos + length < data.length() && 
-                   data[i + length] == data[pos + length]) {
-                length++;
-            }
-            
-            // 更新最长匹配
-            if (length > matchLength) {
-                matchLength = length;
-                matchOffset = pos - i;
-            }
-        }
-        
-        // 获取下一个字符
-        char nextChar = (pos + matchLength < data.length()) 
-                        ? data[pos + matchLength] : '\0';
-        
-        return LZ77Token(matchOffset, matchLength, nextChar);
+// 压缩后解压，解压结果与原始数据一致时返回true，packed为压缩数据
+static bool roundTrip(const string& input, int level, size_t threadCount, string& packed) {
+    StringSink packedSink;
+    auto compressor = Compress::createCompressor("LZ77", packedSink, level, threadCount);
+    if (!compressor || !compressor->write(input.data(), input.size()) || !compressor->finish()) return false;
+
+    StringSink out;
+    auto decompressor = Compress::createDecompressor("LZ77", out, threadCount);
+    if (!decompressor || !decompressor->write(packedSink.m_data.data(), packedSink.m_data.size()) ||
+        !decompressor->finish()) {
+        return false;
+    }
+    packed = std::move(packedSink.m_data);
+    return out.m_data == input;
+}
+
+// 哈希链匹配查找：很长的重复在每个级别都被匹配掉；同一哈希的候选很多时，
+// 链深度足够的级别能沿链找到较早的那一处
+static void testHashChain(mt19937& rng) {
+    string pattern = randomBytes(rng, 1000);
+    string repeated;
+    while (repeated.size() < (10 << 20)) repeated += pattern;
+    for (int level = Compress::kMinLevel; level <= Compress::kMaxLevel; level++) {
+        string packed;
+        check(roundTrip(repeated, level, 1, packed) && packed.size() < repeated.size() / 100,
+              "级别" + to_string(level) + "没有匹配掉10MB的重复数据（" + to_string(packed.size()) + "字节）");
+    }
+
+    // 3000段以相同4字节开头的数据，末尾重复第一段（其后的候选都只匹配开头几个字节）
+    vector<string> segments;
+    string prefix;
+    for (int i = 0; i < 3000; i++) {
+        segments.push_back("abcd" + randomBytes(rng, 60));
+        prefix += segments.back();
+    }
+    string withRepeat = prefix + segments[0], withoutRepeat = prefix + "abcd" + randomBytes(rng, 60);
+    string a, b;
+    check(roundTrip(withRepeat, Compress::kMaxLevel, 1, a) && roundTrip(withoutRepeat, Compress::kMaxLevel, 1, b) &&
+          a.size() + 40 < b.size(), "沿哈希链没有找到较早的匹配（" + to_string(a.size()) + " / " +
+          to_string(b.size()) + "）");
+}
+
+// 按pieceSize字节分段写入压缩/解压，返回压缩数据
+static bool compressPieces(const string& input, int level, size_t pieceSize, string& packed) {
+    StringSink sink;
+    auto compressor = Compress::createCompressor("LZ77", sink, level, 1);
+    for (size_t pos = 0; pos < input.size(); pos += pieceSize) {
+        if (!compressor->write(input.data() + pos, min(pieceSize, input.size() - pos))) return false;
     }
+    if (!compressor->finish()) return false;
+    packed = std::move(sink.m_data);
+    return true;
+}
 
+// 检查收到的数据是pattern的循环重复，只计数不保存
+class PatternSink : public ByteSink {
 public:
-    // 压缩函数
-    bool Compress(const string& srcFile, const string& destFile) {
-        ifstream in(srcFile, ios::binary);
-        ofstream out(destFile, ios::binary);
-        if (!in.is_open() || !out.is_open()) return false;
-
-        string input((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
-        int pos = 0;
-        
-        while (pos < input.length()) {
-            LZ77Token token = findLongestMatch(input, pos);
-            // 写入压缩数据：offset(2字节), length(1字节), nextChar(1字节)
-            out.write((char*)&token.offset, 2);
-            out.write((char*)&token.length, 2);
-            out.write(&token.nextChar, 1);
-            // 移动位置：匹配长度 + 1（下一个字符）
-            pos += token.length + 1;
+    explicit PatternSink(const string& pattern) : m_pattern(pattern) {}
+
+    bool write(const char* data, size_t len) override {
+        while (len > 0) {
+            size_t offset = m_size % m_pattern.size();
+            size_t n = min(len, m_pattern.size() - offset);
+            if (memcmp(data, m_pattern.data() + offset, n) != 0) m_ok = false;
+            data += n;
+            len -= n;
+            m_size += n;
         }
-        in.close();
-        out.close();
         return true;
     }
-    
-    // 解压函数
-    bool Decompress(const string& compressFile, const string& destFile) {
-        ifstream in(compressFile, ios::binary);
-        ofstream out(destFile, ios::binary);
-        if (!in.is_open() || !out.is_open()) return false;
-        string output;
-        while(in.peek() != EOF) {
-            LZ77Token token;
-            // 读取压缩数据：offset(2字节), length(1字节), nextChar(1字节)
-            in.read((char*)&token.offset, 2);
-            in.read((char*)&token.length, 2);
-            in.read(&token.nextChar, 1);
-
-            // 从之前的位置复制匹配的字符串
-            if (token.length > 0 && token.offset > 0) {
-                int startPos = output.length() - token.offset;
-                for (int i = 0; i < token.length; i++) {
-                    output += output[startPos + i];
+    bool finish() override { return true; }
+
+    const string& m_pattern;
+    uint64_t m_size = 0;
+    bool m_ok = true;
+};
+
+static long maxRssKb() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+// 滑动窗口跨越数据块：匹配可引用前面块的数据，结果与写入的分段方式无关；
+// 任意长的数据流经压缩、解压，内存占用不随数据量增长
+static void testWindow(mt19937& rng) {
+    string chunk = randomBytes(rng, 700 << 10);
+    string input = chunk + chunk + chunk, whole, pieces;
+    check(compressPieces(input, Compress::kDefaultLevel, input.size(), whole) &&
+          whole.size() < chunk.size() + chunk.size() / 20,
+          "跨块的重复没有被匹配（" + to_string(whole.size()) + "字节）");
+    check(compressPieces(input, Compress::kDefaultLevel, 777, pieces) && pieces == whole, "分段写入的压缩结果不同");
+
+    StringSink out;
+    auto decompressor = Compress::createDecompressor("LZ77", out, 1);
+    bool ok = true;
+    for (size_t pos = 0; ok && pos < whole.size(); pos += 777) {
+        ok = decompressor->write(whole.data() + pos, min<size_t>(777, whole.size() - pos));
+    }
+    check(decompressor->finish() && ok && out.m_data == input, "分段写入的解压结果不一致");
+
+    // 256MB数据流：压缩直接接解压，峰值内存的增长应远小于数据量
+    string pattern = randomText(rng, (1 << 20) + 17);
+    long rssBefore = maxRssKb();
+    PatternSink check256(pattern);
+    auto streamDecompressor = Compress::createDecompressor("LZ77", check256, 1);
+    auto streamCompressor = Compress::createCompressor("LZ77", *streamDecompressor, 1, 1);
+    const uint64_t total = uint64_t(256) << 20;
+    ok = true;
+    for (uint64_t pos = 0; ok && pos < total; pos += pattern.size()) {
+        ok = streamCompressor->write(pattern.data(), min<uint64_t>(pattern.size(), total - pos));
+    }
+    check(streamCompressor->finish() && ok && check256.m_ok && check256.m_size == total, "256MB数据流往返不一致");
+    check(maxRssKb() - rssBefore < (64 << 10),
+          "256MB数据流的峰值内存增长" + to_string((maxRssKb() - rssBefore) >> 10) + "MB");
+}
+
+// 重叠复制：偏移量小于匹配长度（周期1-40的重复）时按块复制不能读到尚未写出的数据；
+// 匹配长度取块复制宽度附近的值，也有恰好结束在数据末尾的匹配
+static void testOverlapCopy(mt19937& rng) {
+    string all;
+    for (size_t period = 1; period <= 40; period++) {
+        string unit = randomBytes(rng, period);
+        for (size_t len : {period + 4, period + 15, period + 16, period + 17, size_t(100), 1000 + period}) {
+            string run;
+            while (run.size() < len) run += unit;
+            run.resize(len);
+            string packed;
+            check(roundTrip(run, Compress::kDefaultLevel, 1, packed),
+                  "周期" + to_string(period) + "、长度" + to_string(len) + "的重复往返不一致");
+            all += randomBytes(rng, 5) + run;
+        }
+    }
+    for (int level : {Compress::kMinLevel, Compress::kDefaultLevel, Compress::kMaxLevel}) {
+        string packed;
+        check(roundTrip(all, level, 1, packed), "级别" + to_string(level) + "的重叠复制往返不一致");
+    }
+}
+
+// 匹配长度比较（SSE2/AVX2按16/32字节比较）：不同位置出现第一个不同字节，
+// 以及匹配一直延伸到数据末尾（比较长度被剩余数据限制）时，结果都要准确
+static void testMatchLength(mt19937& rng) {
+    string all;
+    for (size_t mismatch = 0; mismatch < 100; mismatch++) {
+        string seg = randomBytes(rng, 128), copy = seg;
+        copy[mismatch] ^= 1;
+        all += seg + randomBytes(rng, 3) + copy + randomBytes(rng, 3);
+    }
+    for (int level : {Compress::kMinLevel, Compress::kDefaultLevel, Compress::kMaxLevel}) {
+        string packed;
+        check(roundTrip(all, level, 1, packed), "级别" + to_string(level) + "在各位置失配的匹配往返不一致");
+    }
+
+    string seg = randomBytes(rng, 100);
+    for (size_t len = 4; len <= seg.size(); len++) {
+        string input = seg + randomBytes(rng, 5) + seg.substr(0, len), packed;
+        check(roundTrip(input, Compress::kDefaultLevel, 1, packed), "到达数据末尾、长" + to_string(len) + "的匹配往返不一致");
+    }
+}
+
+// 每个压缩级别、单线程/多线程的往返，远距离重复只有大窗口能找到
+static void testLevels(mt19937& rng) {
+    // 同一段随机数据间隔约300KB和约900KB重复出现：64KB窗口（级别1）找不到这些重复，
+    // 1MB窗口（级别3以上）可以。总长超过一个数据块，检验跨块的历史窗口
+    string chunk = randomBytes(rng, 48 << 10);
+    string farRepeats = chunk + randomBytes(rng, 256 << 10) + chunk + randomBytes(rng, 850 << 10) + chunk;
+
+    struct Case {
+        const char* name;
+        string data;
+        bool compressible;      // 任何级别都应压缩变小
+    };
+    vector<Case> cases = {
+        {"空数据", "", false},
+        {"单字节", "x", false},
+        {"全零", string((1 << 20) + 4321, '\0'), true},
+        {"文本", randomText(rng, (1 << 20) + 12345), true},
+        {"随机数据", randomBytes(rng, 300 << 10), false},
+        {"远距离重复", farRepeats, false},
+    };
+
+    size_t farSize[Compress::kMaxLevel + 1] = {};
+    for (int level = Compress::kMinLevel; level <= Compress::kMaxLevel; level++) {
+        for (size_t threads : {1, 4}) {
+            for (const auto& c : cases) {
+                string packed;
+                if (!roundTrip(c.data, level, threads, packed)) {
+                    check(false, "级别" + to_string(level) + "，" + to_string(threads) + "线程，" + c.name);
+                    continue;
                 }
-            }
-            // 添加下一个字符
-            if (token.nextChar != '\0') {
-                output += token.nextChar;
+                check(!c.compressible || packed.size() < c.data.size(),
+                      "级别" + to_string(level) + "，" + c.name + "没有被压缩");
+                if (&c == &cases.back()) farSize[level] = packed.size();
             }
         }
-        out.write(output.c_str(), output.size());
-        in.close();
-        out.close();
-        return true;
     }
-    
-};
 
+    // 重复的三段中后两段应被匹配掉（至少省下一段的大小）
+    for (int level = 3; level <= Compress::kMaxLevel; level++) {
+        check(farSize[level] + chunk.size() <= farSize[1],
+              "级别" + to_string(level) + "没有匹配到窗口内的远距离重复（" + to_string(farSize[level]) +
+              "，级别1为" + to_string(farSize[1]) + "）");
+    }
+}
 
 int main() {
-    LZ77Compress lz77;
-    
-    // 测试示例1：简单重复字符串
-    cout << "========== 测试1：重复字符串 ==========" << endl;
-    string srcfile = "./data/file.txt";
-    string destfile = "./data/file.lz77";
-    string decompressedfile = "./data/file_decompressed.txt";
-    
-    lz77.Compress(srcfile,destfile);
-    lz77.Decompress(destfile,decompressedfile);
-
-    string cmd = "diff " + srcfile + " " + decompressedfile;
-    int result = system(cmd.c_str());
-    if (result == 0) {
-        cout << "测试1通过：解压文件与原文件一致" << endl;
-    } else {
-        cout << "测试1失败：解压文件与原文件不一致" << endl;
-    }
-    return 0;
-}
\ No newline at end of file
+    mt19937 rng(12345);
+
+    testHashChain(rng);
+    testWindow(rng);
+    testOverlapCopy(rng);
+    testMatchLength(rng);
+    testLevels(rng);
+
+    return testResult("LZ77");
+}
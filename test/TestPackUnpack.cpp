@@ -0,0 +1,240 @@
+// tar打包/解包测试：生成的目录树打包后经压缩、解压、解包还原（与备份/还原的流水线一致），
+// 比较文件内容、类型、权限、时间、符号链接和硬链接；手工构造的恶意归档不能写到目标目录之外
+#include <string>
+#include <vector>
+#include <filesystem>
+#include <cstring>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "PackUnpack.h"
+#include "Compress.h"
+#include "spdlog/spdlog.h"
+#include "TestUtil.h"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+static fs::path g_root;
+
+// 生成目录树：普通文件、空文件、大文件、长名称、符号链接、硬链接、空目录、特殊权限
+static void makeTree(const fs::path& src) {
+    fs::create_directories(src / "docs" / "deep" / "deeper");
+    fs::create_directories(src / "empty_dir");
+    writeFile(src / "docs" / "a.txt", "hello backup\n");
+    writeFile(src / "docs" / "empty.txt", "");
+    string big;
+    for (long long i = 0; i < 300000; i++) big += to_string(i * 7919) + ",";
+    writeFile(src / "docs" / "deep" / "big.csv", big);
+    fs::create_directories(src / string(110, 'd'));
+    writeFile(src / string(110, 'd') / string(120, 'n'), "long name\n");
+    writeFile(src / "docs" / "deep" / "deeper" / "script.sh", "#!/bin/sh\n");
+    chmod((src / "docs" / "deep" / "deeper" / "script.sh").c_str(), 0751);
+    fs::create_symlink("docs/a.txt", src / "link");
+    fs::create_symlink(string(150, 'x'), src / "long_link");
+    fs::create_hard_link(src / "docs" / "a.txt", src / "hard");
+    struct timespec times[2] = {{1000000000, 0}, {1000000000, 0}};
+    utimensat(AT_FDCWD, (src / "docs").c_str(), times, 0);
+}
+
+// 按目录在前的顺序列出src下的全部条目，归档内名称为相对路径
+static vector<PackUnpack::PackEntry> listTree(const fs::path& src) {
+    vector<PackUnpack::PackEntry> entries;
+    for (auto it = fs::recursive_directory_iterator(src); it != fs::recursive_directory_iterator(); ++it) {
+        entries.push_back({it->path(), it->path().lexically_relative(src).string()});
+    }
+    return entries;
+}
+
+static bool packEntries(const vector<PackUnpack::PackEntry>& list, ByteSink& out) {
+    BoundedQueue<PackUnpack::PackEntry> entries(list.size() + 1);
+    for (const auto& entry : list) entries.push(entry);
+    entries.close();
+    return PackUnpack::pack(entries, out, "tar");
+}
+
+// 解包：归档按pieceSize字节切段写入，检验跨段的增量解析
+static bool unpackArchive(const string& archive, const fs::path& destDir, size_t pieceSize = kStreamChunkSize) {
+    auto unpacker = PackUnpack::createUnpacker(destDir.string(), "tar");
+    if (!unpacker) return false;
+    bool ok = true;
+    for (size_t pos = 0; ok && pos < archive.size(); pos += pieceSize) {
+        ok = unpacker->write(archive.data() + pos, min(pieceSize, archive.size() - pos));
+    }
+    return unpacker->finish() && ok;
+}
+
+// 手工构造的ustar条目，用于生成恶意归档
+static void appendRawEntry(string& archive, const string& name, char type, const string& link = "",
+                           const string& data = "") {
+    char header[512] = {};
+    memcpy(header, name.data(), min<size_t>(name.size(), 100));
+    snprintf(header + 100, 8, "%07o", 0644);
+    snprintf(header + 108, 8, "%07o", 0);
+    snprintf(header + 116, 8, "%07o", 0);
+    snprintf(header + 124, 12, "%011llo", (unsigned long long)data.size());
+    snprintf(header + 136, 12, "%011o", 0);
+    header[156] = type;
+    memcpy(header + 157, link.data(), min<size_t>(link.size(), 100));
+    memcpy(header + 257, "ustar", 6);
+    memcpy(header + 263, "00", 2);
+    memset(header + 148, ' ', 8);
+    unsigned int sum = 0;
+    for (char c : header) sum += uint8_t(c);
+    snprintf(header + 148, 8, "%06o", sum);
+    archive.append(header, sizeof(header));
+    archive += data;
+    archive.append((512 - data.size() % 512) % 512, '\0');
+}
+
+static void endRawArchive(string& archive) {
+    archive.append(1024, '\0');
+}
+
+// 比较两棵目录树：类型、内容、符号链接目标、权限和修改时间
+static void compareTrees(const fs::path& expected, const fs::path& actual) {
+    size_t count = 0;
+    for (auto it = fs::recursive_directory_iterator(expected); it != fs::recursive_directory_iterator(); ++it) {
+        fs::path rel = it->path().lexically_relative(expected);
+        fs::path other = actual / rel;
+        struct stat a, b;
+        if (lstat(it->path().c_str(), &a) != 0 || lstat(other.c_str(), &b) != 0) {
+            check(false, "缺少条目：" + rel.string());
+            continue;
+        }
+        count++;
+        check((a.st_mode & S_IFMT) == (b.st_mode & S_IFMT), "类型不同：" + rel.string());
+        if (S_ISLNK(a.st_mode)) {
+            check(fs::read_symlink(it->path()) == fs::read_symlink(other), "符号链接目标不同：" + rel.string());
+            continue;
+        }
+        check((a.st_mode & 07777) == (b.st_mode & 07777), "权限不同：" + rel.string());
+        check(a.st_mtime == b.st_mtime, "修改时间不同：" + rel.string());
+        string x, y;
+        if (S_ISREG(a.st_mode)) check(readFile(it->path(), x) && readFile(other, y) && x == y, "内容不同：" + rel.string());
+    }
+    size_t actualCount = 0;
+    for (auto it = fs::recursive_directory_iterator(actual); it != fs::recursive_directory_iterator(); ++it) {
+        actualCount++;
+    }
+    check(count == actualCount, "条目数不同：" + to_string(count) + " / " + to_string(actualCount));
+}
+
+// 流式备份/还原：tar直接写入压缩阶段，解压结果直接解包，中间不落盘
+static void testStreaming(const fs::path& src) {
+    for (const char* alg : {"LZ77", "Haff"}) {
+        StringSink packed;
+        auto compressor = Compress::createCompressor(alg, packed);
+        check(compressor && packEntries(listTree(src), *compressor), string(alg) + " 打包失败");
+
+        fs::path out = g_root / (string("stream_") + alg);
+        fs::create_directories(out);
+        auto unpacker = PackUnpack::createUnpacker(out.string(), "tar");
+        auto decompressor = Compress::createDecompressor(alg, *unpacker);
+        bool ok = decompressor->write(packed.m_data.data(), packed.m_data.size());
+        check(decompressor->finish() && ok, string(alg) + " 解包失败");
+        compareTrees(src, out);
+
+        struct stat a, b;
+        check(lstat((out / "hard").c_str(), &a) == 0 && lstat((out / "docs" / "a.txt").c_str(), &b) == 0 &&
+              a.st_ino == b.st_ino, string(alg) + " 硬链接没有还原");
+    }
+
+    // 归档为GNU tar格式（tar(1)可读）
+    StringSink archive;
+    check(packEntries(listTree(src), archive) && archive.m_data.size() % 512 == 0 &&
+          archive.m_data.compare(257, 8, string("ustar  \0", 8)) == 0, "归档不是GNU tar格式");
+}
+
+// 还原：在目标目录下直接解包，路径不能离开目标目录
+static void testExtract(const fs::path& src) {
+    StringSink archive;
+    check(packEntries(listTree(src), archive), "打包失败");
+
+    // 归档按小段写入；再次解包到同一目录时覆盖已存在的文件和符号链接
+    fs::path out = g_root / "extract";
+    fs::create_directories(out);
+    check(unpackArchive(archive.m_data, out, 777), "分段写入解包失败");
+    compareTrees(src, out);
+    check(unpackArchive(archive.m_data, out), "覆盖解包失败");
+    compareTrees(src, out);
+
+    // 截断的归档必须报错
+    spdlog::set_level(spdlog::level::off);
+    fs::create_directories(g_root / "truncated");
+    check(!unpackArchive(archive.m_data.substr(0, archive.m_data.size() / 2), g_root / "truncated"),
+          "截断的归档没有报错");
+
+    // 先建指向目标目录之外的符号链接，再经过它写文件
+    fs::path outside = g_root / "outside";
+    fs::create_directories(outside);
+    string evil;
+    appendRawEntry(evil, "evil", '2', outside.string());
+    appendRawEntry(evil, "evil/pwn", '0', "", "pwned\n");
+    endRawArchive(evil);
+    fs::create_directories(g_root / "evil_out");
+    check(!unpackArchive(evil, g_root / "evil_out"), "经过符号链接的条目没有报错");
+    check(!fs::exists(outside / "pwn"), "文件被写到目标目录之外");
+
+    // 指向自身的符号链接：不能抛出异常终止进程
+    string loop;
+    appendRawEntry(loop, "a", '2', "a");
+    appendRawEntry(loop, "a/b", '0', "", "x");
+    endRawArchive(loop);
+    fs::create_directories(g_root / "loop_out");
+    check(!unpackArchive(loop, g_root / "loop_out"), "自引用符号链接下的条目没有报错");
+    spdlog::set_level(spdlog::level::info);
+
+    // 含".."的条目跳过，绝对路径去掉开头的"/"后放在目标目录内，pax扩展头中的路径优先于ustar名称
+    string escape, data;
+    appendRawEntry(escape, "../escaped", '0', "", "x");
+    appendRawEntry(escape, (outside / "absolute").string(), '0', "", "x");
+    string record = " path=pax/long_" + string(120, 'p') + "\n";
+    record = to_string(record.size() + 3) + record;
+    appendRawEntry(escape, "PaxHeader", 'x', "", record);
+    appendRawEntry(escape, "short", '0', "", "pax");
+    appendRawEntry(escape, "ok.txt", '0', "", "ok");
+    endRawArchive(escape);
+    fs::path escapeOut = g_root / "escape_out" / "inner";
+    fs::create_directories(escapeOut);
+    check(unpackArchive(escape, escapeOut), "含不安全路径的归档解包失败");
+    check(!fs::exists(escapeOut.parent_path() / "escaped") && !fs::exists(outside / "absolute") &&
+          fs::exists(escapeOut / outside.relative_path() / "absolute"), "不安全路径没有被限制在目标目录内");
+    check(readFile(escapeOut / "pax" / ("long_" + string(120, 'p')), data) && data == "pax" &&
+          !fs::exists(escapeOut / "short"), "pax扩展头中的路径没有生效");
+    check(readFile(escapeOut / "ok.txt", data) && data == "ok", "不安全路径之后的条目没有解包");
+}
+
+// 遍历之后被删除的文件：警告并跳过，不留下不完整的条目，其余条目照常打包
+static void testVanished(const fs::path& src) {
+    vector<PackUnpack::PackEntry> list = listTree(src);
+    list.insert(list.begin() + list.size() / 2, {g_root / "vanished.txt", "vanished.txt"});
+    list.push_back({g_root / "vanished_dir" / "x", "vanished_dir/x"});
+
+    StringSink archive;
+    spdlog::set_level(spdlog::level::off);
+    check(packEntries(list, archive), "含已删除文件的列表打包失败");
+    spdlog::set_level(spdlog::level::info);
+
+    fs::path out = g_root / "vanished_out";
+    fs::create_directories(out);
+    check(unpackArchive(archive.m_data, out), "跳过已删除文件后的归档解包失败");
+    compareTrees(src, out);
+}
+
+int main() {
+    g_root = makeTempDir();
+    if (g_root.empty()) {
+        cout << "无法创建临时目录" << endl;
+        return 1;
+    }
+    fs::path src = g_root / "src";
+    makeTree(src);
+
+    testStreaming(src);
+    testExtract(src);
+    testVanished(src);
+
+    std::error_code ec;
+    fs::remove_all(g_root, ec);
+    return testResult("打包");
+}
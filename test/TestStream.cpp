@@ -0,0 +1,115 @@
+// 流水线测试：ThreadedSink把下游阶段放到独立线程后，数据顺序不变；下游出错或抛出异常时
+// 上游得到失败而不是阻塞或终止进程；未调用finish即析构时不结束下游
+#include <string>
+#include <stdexcept>
+#include "Stream.h"
+#include "Compress.h"
+#include "spdlog/spdlog.h"
+#include "TestUtil.h"
+
+using namespace std;
+
+// 记录收到的数据和finish调用次数，可在写入若干字节后失败或抛出异常
+class RecordSink : public ByteSink {
+public:
+    enum Fault { kNone, kFail, kThrow };
+
+    RecordSink(Fault fault = kNone, size_t faultAfter = 0) : m_fault(fault), m_faultAfter(faultAfter) {}
+
+    bool write(const char* data, size_t len) override {
+        if (m_fault != kNone && m_data.size() + len > m_faultAfter) {
+            if (m_fault == kThrow) throw runtime_error("测试异常");
+            return false;
+        }
+        m_data.append(data, len);
+        return true;
+    }
+    bool finish() override {
+        m_finishCalls++;
+        return true;
+    }
+
+    string m_data;
+    int m_finishCalls = 0;
+
+private:
+    Fault m_fault;
+    size_t m_faultAfter;
+};
+
+// 随机长度（可能跨越缓冲块边界）依次写入
+static bool writePieces(ByteSink& sink, const string& data, mt19937& rng) {
+    for (size_t pos = 0; pos < data.size();) {
+        size_t n = min<size_t>(rng() % (3 << 20), data.size() - pos);
+        if (!sink.write(data.data() + pos, n)) return false;
+        pos += n;
+    }
+    return true;
+}
+
+static void testThreadedSink(mt19937& rng) {
+    string data = randomBytes(rng, (9 << 20) + 12345);
+
+    // 三级串联，每级只有2个缓冲块：数据按顺序到达，下游只结束一次
+    {
+        RecordSink out;
+        ThreadedSink third(out, 2), second(third, 2), first(second, 2);
+        check(writePieces(first, data, rng) && first.finish(), "串联写入失败");
+        check(out.m_data == data, "经过ThreadedSink后数据不一致");
+        check(out.m_finishCalls == 1, "下游finish调用次数：" + to_string(out.m_finishCalls));
+        check(first.finish(), "重复调用finish应返回同一结果");
+    }
+
+    // 下游在写入3MB后失败：上游写入最终返回false，finish报错，不会阻塞
+    spdlog::set_level(spdlog::level::off);
+    for (auto fault : {RecordSink::kFail, RecordSink::kThrow}) {
+        string name = fault == RecordSink::kFail ? "下游失败" : "下游抛出异常";
+        RecordSink out(fault, 3 << 20);
+        ThreadedSink stage(out);
+        bool ok = true;
+        for (int i = 0; i < 64 && ok; i++) ok = stage.write(data.data(), 1 << 20);
+        check(!ok, name + "后上游写入没有失败");
+        check(!stage.finish(), name + "后finish没有报错");
+        check(out.m_finishCalls == 0, name + "后不应结束下游");
+    }
+
+    // 与备份流水线相同的串联：ThreadedSink -> 多线程压缩 -> ThreadedSink -> 抛出异常的下游
+    {
+        RecordSink out(RecordSink::kThrow, 1 << 20);
+        ThreadedSink writeStage(out);
+        auto compressor = Compress::createCompressor("Haff", writeStage, Compress::kDefaultLevel, 4);
+        ThreadedSink compressStage(*compressor);
+        bool ok = writePieces(compressStage, data, rng);
+        check(!(compressStage.finish() && ok), "压缩阶段之后的下游异常没有报错");
+    }
+    spdlog::set_level(spdlog::level::info);
+
+    // 未调用finish即析构：已写入的数据交给下游，但下游不被结束
+    {
+        RecordSink out;
+        {
+            ThreadedSink stage(out);
+            stage.write(data.data(), 100);
+        }
+        check(out.m_finishCalls == 0, "未调用finish的ThreadedSink结束了下游");
+    }
+}
+
+// 有界队列：close之后push失败，pop先取完剩余元素
+static void testBoundedQueue() {
+    BoundedQueue<int> queue(4);
+    check(queue.push(1) && queue.push(2), "队列push失败");
+    queue.close();
+    int v = 0;
+    check(!queue.push(3), "close之后push应失败");
+    check(queue.pop(v) && v == 1 && queue.pop(v) && v == 2 && !queue.pop(v), "close之后没有取完剩余元素");
+}
+
+int main() {
+    mt19937 rng(20240603);
+
+    testThreadedSink(rng);
+    testBoundedQueue();
+
+    return testResult("流水线");
+}
@@ -0,0 +1,81 @@
+// 测试共用的工具：失败计数与检查、收集流水线输出的内存阶段、读写文件、临时目录、随机测试数据
+#pragma once
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <random>
+#include <filesystem>
+#include <cstdlib>
+#include "Stream.h"
+
+inline int g_failed = 0;
+
+inline void check(bool ok, const std::string& what) {
+    if (!ok) {
+        std::cout << "测试失败：" << what << std::endl;
+        g_failed++;
+    }
+}
+
+// 输出测试结果，作为main的返回值
+inline int testResult(const std::string& name) {
+    if (g_failed == 0) {
+        std::cout << name << "测试通过" << std::endl;
+        return 0;
+    }
+    std::cout << name << "测试失败：" << g_failed << "项" << std::endl;
+    return 1;
+}
+
+// 收集流水线输出的内存阶段
+class StringSink : public ByteSink {
+public:
+    bool write(const char* data, size_t len) override {
+        m_data.append(data, len);
+        return true;
+    }
+    bool finish() override { return true; }
+
+    std::string m_data;
+};
+
+inline bool readFile(const std::string& path, std::string& data) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open()) return false;
+    std::stringstream ss;
+    ss << in.rdbuf();
+    data = ss.str();
+    return true;
+}
+
+inline void writeFile(const std::string& path, const std::string& data) {
+    std::ofstream out(path, std::ios::binary);
+    out << data;
+}
+
+// 在/tmp下创建本次测试的临时目录，失败时返回空路径
+inline std::filesystem::path makeTempDir() {
+    char tmpl[] = "/tmp/fbk_test_XXXXXX";
+    return mkdtemp(tmpl) ? std::filesystem::path(tmpl) : std::filesystem::path();
+}
+
+// alphabet小于256时只取'a'开始的alphabet个字符
+inline std::string randomBytes(std::mt19937& rng, size_t size, unsigned alphabet = 256) {
+    std::string s(size, '\0');
+    for (auto& c : s) c = alphabet < 256 ? char('a' + rng() % alphabet) : char(rng());
+    return s;
+}
+
+// 由小词表随机组成的文本，重复多、匹配短
+inline std::string randomText(std::mt19937& rng, size_t size) {
+    static const char* words[] = {"backup", "restore", "file", "archive", "tar", "compress", "dictionary",
+                                  "window", "match", "offset", "length", "block", "\n", "    "};
+    std::string s;
+    while (s.size() < size) {
+        s += words[rng() % (sizeof(words) / sizeof(words[0]))];
+        s += ' ';
+    }
+    s.resize(size);
+    return s;
+}
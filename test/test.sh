@@ -27,4 +27,21 @@ echo "测试加密备份：用户名=test, 密码=123456" > test_backup_dir/secr
 
 # ============== 6. 验证目录创建完成 ==============
 echo "测试目录创建完成！目录结构："
-tree test_backup_dir/  # 若未安装tree，执行：apt install tree -y 后再运行
\ No newline at end of file
+tree test_backup_dir/  # 若未安装tree，执行：apt install tree -y 后再运行
+
+# ============== 7. 编译并运行压缩、打包测试（不依赖GTKmm/Crypto++） ==============
+CXX=${CXX:-g++}
+mkdir -p bin
+TEST_FLAGS="-std=c++17 -O2 -I../src -I../src/core -I../external -pthread"
+$CXX $TEST_FLAGS TestLz77.cpp ../src/core/Compress.cpp ../src/core/Stream.cpp -o bin/TestLz77 || exit 1
+./bin/TestLz77 || exit 1
+$CXX $TEST_FLAGS TestCompress.cpp ../src/core/Compress.cpp ../src/core/Stream.cpp -o bin/TestCompress || exit 1
+./bin/TestCompress data || exit 1
+$CXX $TEST_FLAGS TestPackUnpack.cpp ../src/core/PackUnpack.cpp ../src/core/Compress.cpp ../src/core/Stream.cpp \
+    ../src/core/OwnerCache.cpp -o bin/TestPackUnpack || exit 1
+./bin/TestPackUnpack || exit 1
+$CXX $TEST_FLAGS TestStream.cpp ../src/core/Compress.cpp ../src/core/Stream.cpp -o bin/TestStream || exit 1
+./bin/TestStream || exit 1
+$CXX $TEST_FLAGS TestFilter.cpp ../src/core/DirWalker.cpp ../src/core/Filter.cpp ../src/core/NameMatcher.cpp \
+    ../src/core/PathTrie.cpp ../src/core/OwnerCache.cpp -o bin/TestFilter || exit 1
+./bin/TestFilter || exit 1